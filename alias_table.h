@@ -0,0 +1,207 @@
+#ifndef ALIAS_TABLE_H
+#define ALIAS_TABLE_H
+
+#include "random_mt.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Random {
+// Draws index i with probability weights[i] / (sum of weights) in O(1).
+// This is Walker's alias method with Vose's O(n) construction: the weights are cut into n
+// columns of equal height, and each column holds at most two indices (its own and one "alias").
+// A draw picks a column uniformly, then flips one biased coin.
+//
+// Changing a few weights doesn't need a full rebuild. The table is built over a "capacity" for
+// every index (>= its weight), and a draw of i is accepted with probability weight / capacity.
+// Lowering a weight, or raising it up to its capacity, is then O(1). A weight that outgrows its
+// capacity gets twice the new weight as headroom at the next rebuild, and when less than half of
+// the table is live weight the table is rebuilt exactly.
+// Sample call:
+//     Random::AliasTable table{std::vector{1.0, 5.0, 2.0}};
+//     std::size_t index{table.sample()}; // 1 is picked 5 times as often as 0
+class AliasTable {
+  public:
+    AliasTable() = default;
+
+    explicit AliasTable(std::span<const double> weights) { assign(weights); }
+
+    // Replaces every weight and rebuilds the table, O(n)
+    void assign(std::span<const double> weights) {
+        for (double weight : weights) {
+            check_weight(weight);
+        }
+        m_weights.assign(weights.begin(), weights.end());
+        rebuild(m_weights);
+    }
+
+    std::size_t size() const noexcept { return m_weights.size(); }
+
+    bool empty() const noexcept { return m_weights.empty(); }
+
+    double weight(std::size_t index) const { return m_weights.at(index); }
+
+    double total_weight() const noexcept { return m_total; }
+
+    // Changes one weight, O(1) unless it outgrows its capacity (see above)
+    void set_weight(std::size_t index, double weight) {
+        std::pair<std::size_t, double> change{index, weight};
+        set_weights(std::span{&change, 1});
+    }
+
+    // Changes several weights, rebuilding at most once
+    void set_weights(std::span<const std::pair<std::size_t, double>> changes) {
+        bool outgrown{false};
+        for (const auto& [index, weight] : changes) {
+            check_weight(weight);
+            if (index >= m_weights.size()) {
+                throw std::out_of_range("AliasTable: index out of range.");
+            }
+            m_total += weight - m_weights[index];
+            m_weights[index] = weight;
+            if (weight > m_capacity[index]) {
+                outgrown = true;
+            } else if (weight != m_capacity[index]) {
+                m_exact = false;
+            }
+        }
+
+        if (outgrown) {
+            std::vector<double> capacity{m_capacity};
+            for (std::size_t i{}; i < capacity.size(); ++i) {
+                if (m_weights[i] > capacity[i]) {
+                    capacity[i] = 2 * m_weights[i];
+                } else if (m_weights[i] == 0) {
+                    capacity[i] = 0;
+                }
+            }
+            rebuild(capacity);
+        } else if (m_total < m_capacity_total / 2) {
+            rebuild(m_weights);
+        }
+    }
+
+    // Draws one index, O(1)
+    template <std::uniform_random_bit_generator Engine> std::size_t sample(Engine& rng) const {
+        if (empty() || !(m_total > 0)) {
+            throw std::logic_error("AliasTable: there is nothing to sample!.");
+        }
+        return draw(rng);
+    }
+
+    std::size_t sample() const { return sample(engine()); }
+
+    // Fills out with independent draws
+    template <std::uniform_random_bit_generator Engine>
+    void sample(Engine& rng, std::span<std::size_t> out) const {
+        if (empty() || !(m_total > 0)) {
+            throw std::logic_error("AliasTable: there is nothing to sample!.");
+        }
+        for (auto& index : out) {
+            index = draw(rng);
+        }
+    }
+
+    void sample(std::span<std::size_t> out) const { sample(engine(), out); }
+
+  private:
+    struct Column {
+        std::uint64_t keep{}; // keep this column's own index when the coin is below this
+        std::size_t alias{};  // otherwise return this one
+    };
+
+    std::vector<double> m_weights{};
+    std::vector<double> m_capacity{}; // what the columns were built for, never below m_weights
+    std::vector<Column> m_columns{};
+    double m_total{};
+    double m_capacity_total{};
+    bool m_exact{true}; // every weight equals its capacity, so no draw is ever rejected
+
+    static void check_weight(double weight) {
+        if (!(weight >= 0) || !std::isfinite(weight)) {
+            throw std::invalid_argument("AliasTable: weights must be finite and non-negative.");
+        }
+    }
+
+    // Probability p in [0, 1] as a 64-bit threshold for a uniform 64-bit coin
+    static std::uint64_t to_threshold(double probability) noexcept {
+        if (probability >= 1.0) {
+            return std::numeric_limits<std::uint64_t>::max();
+        }
+        return static_cast<std::uint64_t>(std::ldexp(probability, 64));
+    }
+
+    // Vose's construction over the given capacities
+    void rebuild(const std::vector<double>& capacity) {
+        std::vector<double> new_capacity{capacity}; // capacity may alias m_weights or m_capacity
+        const std::size_t count{new_capacity.size()};
+
+        double capacity_total{};
+        m_total = 0;
+        for (std::size_t i{}; i < count; ++i) {
+            capacity_total += new_capacity[i];
+            m_total += m_weights[i];
+        }
+
+        m_columns.assign(count, Column{});
+        std::vector<double> scaled(count);
+        std::vector<std::size_t> small{};
+        std::vector<std::size_t> large{};
+        small.reserve(count);
+        large.reserve(count);
+
+        for (std::size_t i{}; i < count; ++i) {
+            // average column height is 1
+            scaled[i] = capacity_total > 0 ? new_capacity[i] * count / capacity_total : 1.0;
+            (scaled[i] < 1.0 ? small : large).push_back(i);
+        }
+
+        while (!small.empty() && !large.empty()) {
+            std::size_t less{small.back()};
+            std::size_t more{large.back()};
+            small.pop_back();
+
+            m_columns[less] = Column{to_threshold(scaled[less]), more};
+            scaled[more] -= 1.0 - scaled[less];
+            if (scaled[more] < 1.0) {
+                large.pop_back();
+                small.push_back(more);
+            }
+        }
+        // Whatever is left is 1 up to rounding error
+        for (std::size_t i : large) {
+            m_columns[i] = Column{to_threshold(1.0), i};
+        }
+        for (std::size_t i : small) {
+            m_columns[i] = Column{to_threshold(1.0), i};
+        }
+
+        m_capacity = std::move(new_capacity);
+        m_capacity_total = capacity_total;
+        m_exact = m_capacity == m_weights;
+    }
+
+    template <typename Engine> std::size_t draw(Engine& rng) const {
+        const std::uint64_t columns{m_columns.size()};
+        while (true) {
+            const Column& column{m_columns[bounded(rng, columns)]};
+            std::size_t index{detail::next_u64(rng) < column.keep
+                                  ? static_cast<std::size_t>(&column - m_columns.data())
+                                  : column.alias};
+            if (m_exact || m_weights[index] >= m_capacity[index] ||
+                random<double>(rng) * m_capacity[index] < m_weights[index]) {
+                return index;
+            }
+        }
+    }
+};
+} // namespace Random
+
+#endif // !ALIAS_TABLE_H
@@ -0,0 +1,135 @@
+/*
+  File: concurrent_queue_benchmark.cpp
+
+  How ConcurrentRandomizedQueue (concurrent_randomized_queue.h) scales with threads, next to a
+  plain RandomizedQueue behind one global mutex.
+
+  Build:
+    g++ -std=c++20 -O2 -Wall -Wextra concurrent_queue_benchmark.cpp -o concurrent_queue_bench \
+        -pthread
+
+  Run:
+    ./concurrent_queue_bench          # 1, 2, 4, ... up to the number of hardware threads
+    ./concurrent_queue_bench 32       # up to 32 threads whatever the machine has
+
+  Every thread does the same number of enqueue + try_dequeue pairs on a queue that starts with
+  2^16 elements. The table shows millions of operations per second, each queue's speedup over
+  its own 1 thread figure, and "vs lock": the sharded throughput over the global lock's at the
+  same thread count. Below 1 the sharded queue is simply slower, however well it scales.
+  Scaling past the number of cores the machine really has means nothing.
+  It finishes with a uniformity check: try_sample counts over the values of a full queue, which
+  should all be close to the expected count.
+*/
+
+#include "concurrent_randomized_queue.h"
+#include "randomized_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// The baseline: the single threaded queue and one lock around everything
+template <typename T> class LockedRandomizedQueue {
+  public:
+    void enqueue(T item) {
+        std::lock_guard lock{m_mutex};
+        m_items.enqueue(std::move(item));
+    }
+
+    auto try_dequeue() -> std::optional<T> {
+        std::lock_guard lock{m_mutex};
+        if (m_items.empty()) {
+            return std::nullopt;
+        }
+        return m_items.dequeue_random();
+    }
+
+  private:
+    std::mutex m_mutex{};
+    RandomizedQueue<T> m_items{RandomizedQueue<T>::Mode::random};
+};
+
+constexpr std::size_t initial_size{std::size_t{1} << 16};
+constexpr std::size_t pairs_per_thread{200'000};
+
+// Millions of operations per second with `threads` threads working on one queue
+template <typename Queue> double million_ops_per_second(unsigned threads) {
+    Queue queue{};
+    for (std::size_t i{}; i < initial_size; ++i) {
+        queue.enqueue(static_cast<int>(i));
+    }
+
+    std::vector<std::thread> pool{};
+    auto start{std::chrono::steady_clock::now()};
+    for (unsigned thread{}; thread < threads; ++thread) {
+        pool.emplace_back([&queue] {
+            for (std::size_t i{}; i < pairs_per_thread; ++i) {
+                queue.enqueue(static_cast<int>(i));
+                if (!queue.try_dequeue()) {
+                    std::abort(); // there is always at least the initial elements
+                }
+            }
+        });
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    std::chrono::duration<double, std::micro> elapsed{std::chrono::steady_clock::now() - start};
+    return 2.0 * static_cast<double>(pairs_per_thread) * threads / elapsed.count();
+}
+
+// Largest relative gap between the try_sample count of any value and the expected count
+double sample_spread(std::size_t values, std::size_t draws) {
+    ConcurrentRandomizedQueue<int> queue{16};
+    for (std::size_t i{}; i < values; ++i) {
+        queue.enqueue(static_cast<int>(i));
+    }
+    std::vector<std::size_t> counts(values);
+    for (std::size_t i{}; i < draws; ++i) {
+        ++counts[static_cast<std::size_t>(*queue.try_sample())];
+    }
+    double expected{static_cast<double>(draws) / static_cast<double>(values)};
+    auto [low, high]{std::minmax_element(counts.begin(), counts.end())};
+    return std::max(expected - static_cast<double>(*low), static_cast<double>(*high) - expected) /
+           expected;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned max_threads{std::max(1U, std::thread::hardware_concurrency())};
+    if (argc > 1) {
+        max_threads = static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10));
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "global lock" << std::setw(10)
+              << "speedup" << std::setw(14) << "sharded" << std::setw(10) << "speedup"
+              << std::setw(10) << "vs lock" << "\n";
+
+    double locked_base{};
+    double sharded_base{};
+    for (unsigned threads{1}; threads <= max_threads; threads *= 2) {
+        double locked{million_ops_per_second<LockedRandomizedQueue<int>>(threads)};
+        double sharded{million_ops_per_second<ConcurrentRandomizedQueue<int>>(threads)};
+        if (threads == 1) {
+            locked_base = locked;
+            sharded_base = sharded;
+        }
+        std::cout << std::setw(8) << threads << std::setw(14) << locked << std::setw(10)
+                  << locked / locked_base << std::setw(14) << sharded << std::setw(10)
+                  << sharded / sharded_base << std::setw(10) << sharded / locked << "\n";
+    }
+    std::cout << "(millions of operations per second)\n\n";
+
+    // 1000 draws per value: about 3 / sqrt(1000) = 0.095 is the spread expected from chance alone
+    std::cout << "try_sample spread over 4096 values in 16 shards: "
+              << sample_spread(4096, 4096 * 1000) << " (about 0.1 is ideal)\n";
+    return 0;
+}
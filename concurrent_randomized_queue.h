@@ -0,0 +1,176 @@
+#ifndef CONCURRENT_RANDOMIZED_QUEUE_H
+#define CONCURRENT_RANDOMIZED_QUEUE_H
+
+#include "random_mt.h"
+#include "randomized_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <utility>
+
+// A RandomizedQueue that many threads can enqueue to and dequeue from at once.
+// The elements are spread over several shards (one per hardware thread by default), each an
+// ordinary RandomizedQueue behind its own mutex, so threads only contend when they happen to hit
+// the same shard:
+// * enqueue puts the element in the emptier of two random shards
+// * try_dequeue and try_sample look at two random shards and pick one of them in proportion to
+//   its size; if that one is busy or empty they steal from the others, visited in a random
+//   order, and only give up once all of them are empty
+// An element is picked by choosing a shard and then an element in it. The two-choice placement
+// keeps the shards within a few elements of each other, so weighing just the two shards looked
+// at keeps every element about equally likely, and no call reads more than two shard sizes
+// unless it has to steal. (Only about: the sizes are read without locking.)
+// There is no throwing dequeue(): another thread may empty the queue between a check and a
+// call, so the try_ calls return std::nullopt instead.
+template <typename T> class ConcurrentRandomizedQueue {
+  private:
+    // Each shard sits on its own cache lines, so locking one never slows down its neighbours.
+    // The size gets a line of its own too: it is read by every thread that picks a shard, and
+    // should not share a line with the mutex and queue that the owner of the lock writes to.
+    struct alignas(64) Shard {
+        std::mutex mutex{};
+        RandomizedQueue<T> items{RandomizedQueue<T>::Mode::random};
+        alignas(64) std::atomic<std::size_t> size{}; // items.size(), readable without the lock
+    };
+
+    std::unique_ptr<Shard[]> m_shards{};
+    std::size_t m_shard_count{};
+
+    // Looks at two random shards and returns the emptier one. Always adding to the emptier of two
+    // keeps the shard sizes within a few elements of each other, which a single random pick
+    // wouldn't.
+    std::size_t emptier_shard() const {
+        auto& rng{Random::engine()};
+        auto first{static_cast<std::size_t>(Random::bounded(rng, m_shard_count))};
+        auto second{static_cast<std::size_t>(Random::bounded(rng, m_shard_count))};
+        std::size_t first_size{m_shards[first].size.load(std::memory_order_relaxed)};
+        std::size_t second_size{m_shards[second].size.load(std::memory_order_relaxed)};
+        return second_size < first_size ? second : first;
+    }
+
+    // Looks at two random shards and returns one of them with probability proportional to its
+    // size, so that a random element of it is close to a uniformly random element of the whole
+    // queue while the shards are about the same size
+    std::size_t weighted_shard() const {
+        auto& rng{Random::engine()};
+        auto first{static_cast<std::size_t>(Random::bounded(rng, m_shard_count))};
+        auto second{static_cast<std::size_t>(Random::bounded(rng, m_shard_count))};
+        std::size_t first_size{m_shards[first].size.load(std::memory_order_relaxed)};
+        std::size_t second_size{m_shards[second].size.load(std::memory_order_relaxed)};
+        if (first_size + second_size == 0) {
+            return first; // find() steals from the others
+        }
+        return Random::bounded(rng, first_size + second_size) < first_size ? first : second;
+    }
+
+    // A random step in [1, shard count) that shares no factor with the shard count, so stepping
+    // by it from any shard visits every shard once
+    std::size_t random_stride() const {
+        if (m_shard_count <= 2) {
+            return 1;
+        }
+        auto& rng{Random::engine()};
+        for (;;) {
+            auto stride{1 + static_cast<std::size_t>(Random::bounded(rng, m_shard_count - 1))};
+            if (std::gcd(stride, m_shard_count) == 1) {
+                return stride;
+            }
+        }
+    }
+
+    // Calls take(shard) under the lock of the first non-empty shard, starting at `first` and then
+    // stepping through the others by a random stride coprime to the shard count, so threads that
+    // find the same shards empty or busy don't all fall back on the same next ones. The first
+    // pass skips shards that are locked; the second one waits for the locks, so std::nullopt only
+    // comes back once every shard has been seen empty.
+    template <typename Take> auto find(std::size_t first, Take take) const -> std::optional<T> {
+        std::size_t stride{}; // only drawn once `first` has been passed over
+        for (int pass{}; pass < 2; ++pass) {
+            for (std::size_t offset{}; offset < m_shard_count; ++offset) {
+                if (offset == 1 && stride == 0) {
+                    stride = random_stride();
+                }
+                Shard& shard{m_shards[(first + offset * stride) % m_shard_count]};
+                if (shard.size.load(std::memory_order_relaxed) == 0) {
+                    continue;
+                }
+                std::unique_lock lock{shard.mutex, std::defer_lock};
+                if (pass == 0) {
+                    if (!lock.try_lock()) {
+                        continue;
+                    }
+                } else {
+                    lock.lock();
+                }
+                if (!shard.items.empty()) {
+                    return take(shard);
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+  public:
+    // shards == 0 means one shard per hardware thread
+    explicit ConcurrentRandomizedQueue(std::size_t shards = 0) : m_shard_count{shards} {
+        if (m_shard_count == 0) {
+            m_shard_count = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+        }
+        m_shards = std::make_unique<Shard[]>(m_shard_count);
+    }
+
+    ConcurrentRandomizedQueue(const ConcurrentRandomizedQueue&) = delete;
+    ConcurrentRandomizedQueue& operator=(const ConcurrentRandomizedQueue&) = delete;
+
+    std::size_t shard_count() const noexcept {
+        return m_shard_count;
+    }
+
+    // The number of elements. Only a snapshot while other threads are working on the queue, and
+    // it reads every shard's size, so it is not meant for hot loops.
+    std::size_t size() const noexcept {
+        std::size_t total{};
+        for (std::size_t index{}; index < m_shard_count; ++index) {
+            total += m_shards[index].size.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    void enqueue(const T& item) {
+        enqueue(T{item});
+    }
+
+    void enqueue(T&& item) {
+        Shard& shard{m_shards[emptier_shard()]};
+        std::lock_guard lock{shard.mutex};
+        shard.items.enqueue(std::move(item));
+        shard.size.store(shard.items.size(), std::memory_order_relaxed);
+    }
+
+    // Removes a random element, or returns std::nullopt if every shard is empty
+    auto try_dequeue() -> std::optional<T> {
+        return find(weighted_shard(), [](Shard& shard) {
+            std::optional<T> value{shard.items.dequeue_random(Random::engine())};
+            shard.size.store(shard.items.size(), std::memory_order_relaxed);
+            return value;
+        });
+    }
+
+    // A copy of a random element, or std::nullopt if every shard is empty
+    auto try_sample() const -> std::optional<T> {
+        return find(weighted_shard(), [](Shard& shard) {
+            return std::optional<T>{shard.items.sample(Random::engine())};
+        });
+    }
+};
+#endif // !CONCURRENT_RANDOMIZED_QUEUE_H
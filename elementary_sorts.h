@@ -6,13 +6,18 @@
 #define ELEMENTARY_SORTS_H
 
 #include "random_mt.h"
+#include "workload_generator.h"
 
+#include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
 #include <limits>
+#include <span>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 /*Mostly for scalar types*/
@@ -34,10 +39,10 @@ template <typename T> class Sorts {
 
     bool empty() const noexcept { return m_data.empty(); }
 
+    std::span<const T> data() const noexcept { return m_data; }
+
     void initialize_randomly() {
-        for (std::size_t index{}; index < m_data.size(); ++index) {
-            m_data[index] = Random::random<T>();
-        }
+        Random::fill_uniform(std::span<T>{m_data});
     }
 
     void initialize_consistent() {
@@ -46,15 +51,20 @@ template <typename T> class Sorts {
         }
     }
 
+    // Fills the data with one of the benchmark input shapes (see workload_generator.h)
+    void initialize(Workload::Shape shape, const Workload::Options& options = {}) {
+        Workload::fill(std::span<T>{m_data}, shape, options);
+    }
+
     void shuffle() {
 
         if (empty()) {
             return;
         }
-        std::size_t first_index{0};
+        auto& rng{Random::engine()};
         for (std::size_t i{}; i < m_data.size(); ++i) {
 
-            std::size_t random_num = Random::get(first_index, i);
+            std::size_t random_num = Random::bounded(rng, i + 1); // [0, i]
             std::swap(m_data[i], m_data[random_num]);
         }
     }
@@ -113,6 +123,23 @@ template <typename T> class Sorts {
         }
     }
 
+    // Pattern-defeating quicksort (Orson Peters, "Pattern-defeating Quicksort", 2021), O(n log n)
+    // in the worst case and O(n) on sorted, reverse sorted and all-equal input:
+    // * pivots are the median of 3, or past 128 elements the median of 3 medians of 3 (a ninther)
+    // * partitioning works on blocks of 64 elements: it first records which elements are on the
+    //   wrong side without a single data-dependent branch, then swaps them in a second loop
+    // * a partition that leaves one side under 1/8 of the range is "bad"; the ends are then
+    //   shuffled around to break the pattern, and after log2(n) bad ones heap sort takes over
+    // * a partition that swapped nothing tries insertion sort on both sides and gives up after 8
+    //   moves, which finishes sorted runs in one pass
+    // * a pivot equal to the one before it puts all the equal elements left and skips them
+    void pdq_sort() {
+        if (m_data.size() > 1) {
+            pdq_loop(m_data.data(), m_data.data() + m_data.size(),
+                     static_cast<int>(std::bit_width(m_data.size())), true);
+        }
+    }
+
     // Empty container is always sorted
     void is_sorted() {
         if (m_data.size() <= 1) {
@@ -138,5 +165,273 @@ template <typename T> class Sorts {
         }
     }
     bool less(const T& lhs, const T& rhs) { return (compare_to(lhs, rhs) < 0); }
+
+  private:
+    static constexpr std::ptrdiff_t pdq_insertion_cutoff{24};
+    static constexpr std::ptrdiff_t pdq_ninther_cutoff{128};
+    static constexpr std::ptrdiff_t pdq_insertion_moves{8};
+    static constexpr std::size_t pdq_block_size{64};
+
+    // Insertion sort of [begin, end)
+    static void pdq_insertion(T* begin, T* end) {
+        for (T* current{begin + 1}; current < end; ++current) {
+            T value{*current};
+            T* hole{current};
+            for (; hole != begin && value < *(hole - 1); --hole) {
+                *hole = *(hole - 1);
+            }
+            *hole = value;
+        }
+    }
+
+    // Same, for a range with an element no bigger than any of it right before begin
+    static void pdq_unguarded_insertion(T* begin, T* end) {
+        for (T* current{begin + 1}; current < end; ++current) {
+            T value{*current};
+            T* hole{current};
+            for (; value < *(hole - 1); --hole) {
+                *hole = *(hole - 1);
+            }
+            *hole = value;
+        }
+    }
+
+    // Insertion sort that gives up (returning false) after pdq_insertion_moves moves
+    static bool pdq_partial_insertion(T* begin, T* end) {
+        std::ptrdiff_t moves{};
+        for (T* current{begin + 1}; current < end; ++current) {
+            T value{*current};
+            T* hole{current};
+            for (; hole != begin && value < *(hole - 1); --hole) {
+                *hole = *(hole - 1);
+            }
+            *hole = value;
+            moves += current - hole;
+            if (moves > pdq_insertion_moves) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void pdq_sort2(T* a, T* b) {
+        T low{std::min(*a, *b)};
+        T high{std::max(*a, *b)};
+        *a = low;
+        *b = high;
+    }
+
+    static void pdq_sort3(T* a, T* b, T* c) {
+        pdq_sort2(a, b);
+        pdq_sort2(b, c);
+        pdq_sort2(a, b);
+    }
+
+    // Partitions [begin, end) around the pivot *begin into [< pivot] pivot [>= pivot] and
+    // returns where the pivot ended up, and whether nothing had to be swapped
+    static std::pair<T*, bool> pdq_partition_right(T* begin, T* end) {
+        T pivot{*begin};
+        T* first{begin};
+        T* last{end};
+
+        // The median selection left an element >= pivot at the end and one <= pivot at begin,
+        // so the first scan can't run off, and the second only can if nothing was < pivot
+        while (*++first < pivot) {
+        }
+        if (first - 1 == begin) {
+            while (first < last && !(*--last < pivot)) {
+            }
+        } else {
+            while (!(*--last < pivot)) {
+            }
+        }
+        bool already_partitioned{first >= last};
+
+        if (!already_partitioned) {
+            std::swap(*first, *last);
+            ++first;
+            pdq_partition_blocks(pivot, first, last);
+        }
+
+        T* pivot_position{first - 1};
+        *begin = *pivot_position;
+        *pivot_position = pivot;
+        return {pivot_position, already_partitioned};
+    }
+
+    // The block partition of [first, last) around pivot. Each side records the offsets of up
+    // to pdq_block_size misplaced elements in a branch-free loop (the comparison result only
+    // moves a counter), then the two lists are swapped pairwise; a side that ran out loads a
+    // new block. On return first == last is the boundary.
+    static void pdq_partition_blocks(T pivot, T*& first, T*& last) {
+        alignas(64) unsigned char offsets_left[pdq_block_size];
+        alignas(64) unsigned char offsets_right[pdq_block_size];
+        T* base_left{first};
+        T* base_right{last};
+        std::size_t count_left{}, count_right{}, start_left{}, start_right{};
+
+        while (first < last) {
+            // Share out what is left between the sides that need a new block
+            auto unknown{static_cast<std::size_t>(last - first)};
+            std::size_t left_split{
+                count_left == 0 ? (count_right == 0 ? unknown / 2 : unknown) : 0};
+            std::size_t right_split{count_right == 0 ? unknown - left_split : 0};
+            left_split = std::min(left_split, pdq_block_size);
+            right_split = std::min(right_split, pdq_block_size);
+
+            for (std::size_t i{}; i < left_split; ++i) {
+                offsets_left[count_left] = static_cast<unsigned char>(i);
+                count_left += !(*first < pivot);
+                ++first;
+            }
+            for (std::size_t i{}; i < right_split;) {
+                offsets_right[count_right] = static_cast<unsigned char>(++i);
+                count_right += *--last < pivot;
+            }
+
+            std::size_t swaps{std::min(count_left, count_right)};
+            for (std::size_t i{}; i < swaps; ++i) {
+                std::swap(base_left[offsets_left[start_left + i]],
+                          *(base_right - offsets_right[start_right + i]));
+            }
+            count_left -= swaps;
+            count_right -= swaps;
+            start_left += swaps;
+            start_right += swaps;
+            if (count_left == 0) {
+                start_left = 0;
+                base_left = first;
+            }
+            if (count_right == 0) {
+                start_right = 0;
+                base_right = last;
+            }
+        }
+
+        // At most one side has misplaced elements left; move them next to the boundary
+        if (count_left > 0) {
+            while (count_left > 0) {
+                std::swap(base_left[offsets_left[start_left + --count_left]], *--last);
+            }
+            first = last;
+        }
+        if (count_right > 0) {
+            while (count_right > 0) {
+                std::swap(*(base_right - offsets_right[start_right + --count_right]), *first);
+                ++first;
+            }
+            last = first;
+        }
+    }
+
+    // Partitions [begin, end) around the pivot *begin into [<= pivot] [> pivot], for a pivot
+    // equal to the one before begin: everything equal to it is then in place for good.
+    // Returns the last element <= pivot.
+    static T* pdq_partition_left(T* begin, T* end) {
+        T pivot{*begin};
+        T* first{begin};
+        T* last{end};
+
+        while (pivot < *--last) {
+        }
+        if (last + 1 == end) {
+            while (first < last && !(pivot < *++first)) {
+            }
+        } else {
+            while (!(pivot < *++first)) {
+            }
+        }
+        while (first < last) {
+            std::swap(*first, *last);
+            while (pivot < *--last) {
+            }
+            while (!(pivot < *++first)) {
+            }
+        }
+
+        *begin = *last;
+        *last = pivot;
+        return last;
+    }
+
+    // Sorts [begin, end). `bad_allowed` is how many more bad partitions to take before falling
+    // back to heap sort; `leftmost` is false when there is an element right before begin that
+    // is no bigger than any of the range.
+    static void pdq_loop(T* begin, T* end, int bad_allowed, bool leftmost) {
+        while (true) {
+            std::ptrdiff_t size{end - begin};
+            if (size < pdq_insertion_cutoff) {
+                if (leftmost) {
+                    pdq_insertion(begin, end);
+                } else {
+                    pdq_unguarded_insertion(begin, end);
+                }
+                return;
+            }
+
+            // The pivot ends up at begin, with the median candidates around it
+            std::ptrdiff_t half{size / 2};
+            if (size > pdq_ninther_cutoff) {
+                pdq_sort3(begin, begin + half, end - 1);
+                pdq_sort3(begin + 1, begin + (half - 1), end - 2);
+                pdq_sort3(begin + 2, begin + (half + 1), end - 3);
+                pdq_sort3(begin + (half - 1), begin + half, begin + (half + 1));
+                std::swap(*begin, *(begin + half));
+            } else {
+                pdq_sort3(begin + half, begin, end - 1);
+            }
+
+            // The pivot is no bigger than the element before the range, so it equals it: every
+            // element equal to it goes left and never has to be looked at again
+            if (!leftmost && !(*(begin - 1) < *begin)) {
+                begin = pdq_partition_left(begin, end) + 1;
+                continue;
+            }
+
+            auto [pivot, already_partitioned]{pdq_partition_right(begin, end)};
+            std::ptrdiff_t left_size{pivot - begin};
+            std::ptrdiff_t right_size{end - (pivot + 1)};
+
+            if (left_size < size / 8 || right_size < size / 8) {
+                if (--bad_allowed == 0) {
+                    std::make_heap(begin, end);
+                    std::sort_heap(begin, end);
+                    return;
+                }
+                // Swap a few elements from the middle of each side to its ends, so that the
+                // next pivots come from somewhere else
+                if (left_size >= pdq_insertion_cutoff) {
+                    std::ptrdiff_t quarter{left_size / 4};
+                    std::swap(*begin, *(begin + quarter));
+                    std::swap(*(pivot - 1), *(pivot - quarter));
+                    if (left_size > pdq_ninther_cutoff) {
+                        std::swap(*(begin + 1), *(begin + (quarter + 1)));
+                        std::swap(*(begin + 2), *(begin + (quarter + 2)));
+                        std::swap(*(pivot - 2), *(pivot - (quarter + 1)));
+                        std::swap(*(pivot - 3), *(pivot - (quarter + 2)));
+                    }
+                }
+                if (right_size >= pdq_insertion_cutoff) {
+                    std::ptrdiff_t quarter{right_size / 4};
+                    std::swap(*(pivot + 1), *(pivot + (1 + quarter)));
+                    std::swap(*(end - 1), *(end - quarter));
+                    if (right_size > pdq_ninther_cutoff) {
+                        std::swap(*(pivot + 2), *(pivot + (2 + quarter)));
+                        std::swap(*(pivot + 3), *(pivot + (3 + quarter)));
+                        std::swap(*(end - 2), *(end - (1 + quarter)));
+                        std::swap(*(end - 3), *(end - (2 + quarter)));
+                    }
+                }
+            } else if (already_partitioned && pdq_partial_insertion(begin, pivot) &&
+                       pdq_partial_insertion(pivot + 1, end)) {
+                return;
+            }
+
+            // Recurse into the left side and loop on the right one
+            pdq_loop(begin, pivot, bad_allowed, leftmost);
+            begin = pivot + 1;
+            leftmost = false;
+        }
+    }
 };
 #endif // !ELEMENTARY_SORTS_H
@@ -0,0 +1,138 @@
+#ifndef LOAD_BALANCER_H
+#define LOAD_BALANCER_H
+
+#include "random_mt.h"
+#include "randomized_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
+
+// Picks a worker for each job with "the power of d choices" (Mitzenmacher, "The Power of Two
+// Choices in Randomized Load Balancing", 2001): sample d workers at random and give the job to
+// the one with the least load. Picking one worker at random leaves the busiest worker about
+// log n / log log n jobs above the average; comparing just two cuts that to about log log n,
+// which is most of the tail latency.
+//
+// The workers 0 .. n - 1 are kept in a RandomizedQueue and picked with its sample calls. Each
+// worker's load is an atomic counter on its own cache line, so any number of threads can
+// assign() and release() at once without a lock. Two threads may now and then pick the same
+// worker at the same moment; that costs one job of imbalance and nothing else.
+// Sample call:
+//     LoadBalancer balancer{backends.size()};
+//     std::size_t worker{balancer.assign()};
+//     ... send the request to backends[worker] ...
+//     balancer.release(worker); // once it is done
+class LoadBalancer {
+  public:
+    // `choices` workers are compared per job, 1 to 8; 1 is plain random assignment
+    explicit LoadBalancer(std::size_t workers, std::size_t choices = 2)
+        : m_loads{std::make_unique<Load[]>(workers)}, m_choices{choices} {
+        if (workers == 0 || choices == 0) {
+            throw std::invalid_argument("LoadBalancer: needs at least one worker and one choice.");
+        }
+        if (choices > max_choices) {
+            throw std::invalid_argument("LoadBalancer: at most 8 choices per job.");
+        }
+        m_workers.reserve(workers);
+        for (std::size_t worker{}; worker < workers; ++worker) {
+            m_workers.enqueue(worker);
+        }
+    }
+
+    std::size_t workers() const noexcept {
+        return m_workers.size();
+    }
+
+    std::size_t choices() const noexcept {
+        return m_choices;
+    }
+
+    // Jobs assigned to `worker` and not released yet
+    std::int64_t load(std::size_t worker) const {
+        return m_loads[check(worker)].jobs.load(std::memory_order_relaxed);
+    }
+
+    // Picks the least loaded of `choices` random workers and counts the job against it
+    template <std::uniform_random_bit_generator Engine> std::size_t assign(Engine& rng) {
+        std::size_t candidates[max_choices];
+        m_workers.sample(rng, m_choices, candidates, Draw::with_replacement);
+        return take(std::span{candidates, m_choices});
+    }
+
+    std::size_t assign() {
+        return assign(Random::engine());
+    }
+
+    // Assigns `jobs` jobs and writes the chosen workers to out, returning the end of what was
+    // written. The candidates come from one sample call per block of jobs, and every job sees
+    // the loads left by the ones before it, so the balance is as good as `jobs` assign() calls.
+    // Sample call: balancer.assign_n(rng, requests.size(), std::back_inserter(workers));
+    template <std::uniform_random_bit_generator Engine, std::output_iterator<std::size_t> Output>
+    Output assign_n(Engine& rng, std::size_t jobs, Output out) {
+        constexpr std::size_t block_jobs{128};
+        std::size_t candidates[block_jobs * max_choices];
+
+        for (std::size_t done{}; done < jobs;) {
+            std::size_t block{std::min(jobs - done, block_jobs)};
+            m_workers.sample(rng, block * m_choices, candidates, Draw::with_replacement);
+            for (std::size_t job{}; job < block; ++job) {
+                *out++ = take(std::span{candidates + job * m_choices, m_choices});
+            }
+            done += block;
+        }
+        return out;
+    }
+
+    template <std::output_iterator<std::size_t> Output>
+    Output assign_n(std::size_t jobs, Output out) {
+        return assign_n(Random::engine(), jobs, out);
+    }
+
+    // Marks `jobs` jobs of `worker` as done
+    void release(std::size_t worker, std::int64_t jobs = 1) {
+        m_loads[check(worker)].jobs.fetch_sub(jobs, std::memory_order_relaxed);
+    }
+
+  private:
+    using Draw = RandomizedQueue<std::size_t>::Draw;
+
+    // More choices than this gain nothing measurable and only cost draws
+    static constexpr std::size_t max_choices{8};
+
+    // One counter per cache line, so busy workers next to each other don't slow each other down
+    struct alignas(64) Load {
+        std::atomic<std::int64_t> jobs{};
+    };
+
+    RandomizedQueue<std::size_t> m_workers{};
+    std::unique_ptr<Load[]> m_loads{};
+    std::size_t m_choices{};
+
+    std::size_t check(std::size_t worker) const {
+        if (worker >= m_workers.size()) {
+            throw std::out_of_range("LoadBalancer: no such worker.");
+        }
+        return worker;
+    }
+
+    std::size_t take(std::span<const std::size_t> candidates) {
+        std::size_t best{candidates[0]};
+        std::int64_t best_load{m_loads[best].jobs.load(std::memory_order_relaxed)};
+        for (std::size_t candidate : candidates.subspan(1)) {
+            std::int64_t candidate_load{m_loads[candidate].jobs.load(std::memory_order_relaxed)};
+            if (candidate_load < best_load) {
+                best = candidate;
+                best_load = candidate_load;
+            }
+        }
+        m_loads[best].jobs.fetch_add(1, std::memory_order_relaxed);
+        return best;
+    }
+};
+#endif // !LOAD_BALANCER_H
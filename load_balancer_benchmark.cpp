@@ -0,0 +1,126 @@
+/*
+  File: load_balancer_benchmark.cpp
+
+  Simulates LoadBalancer (load_balancer.h) with 1 choice (plain random assignment), 2 and 3
+  choices, and 2 choices assigned in batches.
+
+  Build:
+    g++ -std=c++20 -O2 -Wall -Wextra load_balancer_benchmark.cpp -o load_balancer_bench
+
+  Run:
+    ./load_balancer_bench
+    RANDOM_SEED=7 ./load_balancer_bench     # the same simulation on every run
+
+  Two experiments, both with 1000 workers:
+  - static:   1000 * 1000 jobs are assigned and never finish; "excess" is how far the busiest
+              worker ends up above the average of 1000 jobs
+  - queueing: every tick 900 jobs arrive (90% utilisation) and every busy worker finishes one;
+              after a warm-up, the queue depth of every worker is recorded at every tick and
+              its 99th percentile and maximum are reported
+  Plus the cost of one assignment in ns.
+*/
+
+#include "load_balancer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+constexpr std::size_t workers{1000};
+
+struct Policy {
+    const char* name{};
+    std::size_t choices{};
+    bool batched{};
+};
+
+// Assigns `jobs` jobs, one call each or in one batch
+std::vector<std::size_t> assign(LoadBalancer& balancer, const Policy& policy, std::size_t jobs) {
+    std::vector<std::size_t> picks{};
+    picks.reserve(jobs);
+    if (policy.batched) {
+        balancer.assign_n(jobs, std::back_inserter(picks));
+    } else {
+        for (std::size_t job{}; job < jobs; ++job) {
+            picks.push_back(balancer.assign());
+        }
+    }
+    return picks;
+}
+
+std::int64_t static_excess(const Policy& policy) {
+    constexpr std::size_t jobs_per_worker{1000};
+    LoadBalancer balancer{workers, policy.choices};
+    assign(balancer, policy, workers * jobs_per_worker);
+
+    std::int64_t busiest{};
+    for (std::size_t worker{}; worker < workers; ++worker) {
+        busiest = std::max(busiest, balancer.load(worker));
+    }
+    return busiest - static_cast<std::int64_t>(jobs_per_worker);
+}
+
+struct Depths {
+    std::int64_t p99{};
+    std::int64_t max{};
+};
+
+Depths queueing(const Policy& policy) {
+    constexpr std::size_t ticks{3000};
+    constexpr std::size_t warm_up{500};
+    constexpr std::size_t arrivals{workers * 9 / 10};
+    LoadBalancer balancer{workers, policy.choices};
+
+    std::vector<std::int64_t> depths{};
+    depths.reserve((ticks - warm_up) * workers);
+    for (std::size_t tick{}; tick < ticks; ++tick) {
+        assign(balancer, policy, arrivals);
+        for (std::size_t worker{}; worker < workers; ++worker) {
+            if (tick >= warm_up) {
+                depths.push_back(balancer.load(worker));
+            }
+            if (balancer.load(worker) > 0) {
+                balancer.release(worker);
+            }
+        }
+    }
+
+    auto p99{depths.begin() + static_cast<std::ptrdiff_t>(depths.size() * 99 / 100)};
+    std::nth_element(depths.begin(), p99, depths.end());
+    return Depths{*p99, *std::max_element(depths.begin(), depths.end())};
+}
+
+double ns_per_assignment(const Policy& policy) {
+    constexpr std::size_t jobs{1'000'000};
+    LoadBalancer balancer{workers, policy.choices};
+    auto start{std::chrono::steady_clock::now()};
+    auto picks{assign(balancer, policy, jobs)};
+    std::chrono::duration<double, std::nano> elapsed{std::chrono::steady_clock::now() - start};
+    return elapsed.count() / static_cast<double>(picks.size());
+}
+
+int main() {
+    const Policy policies[]{
+        {"random (d = 1)", 1, false},
+        {"two choices", 2, false},
+        {"three choices", 3, false},
+        {"two choices, batched", 2, true},
+    };
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(22) << "policy" << std::setw(15) << "static excess" << std::setw(12)
+              << "p99 depth" << std::setw(12) << "max depth" << std::setw(14) << "ns / assign"
+              << "\n";
+    for (const auto& policy : policies) {
+        Depths depths{queueing(policy)};
+        std::cout << std::setw(22) << policy.name << std::setw(15) << static_excess(policy)
+                  << std::setw(12) << depths.p99 << std::setw(12) << depths.max << std::setw(14)
+                  << ns_per_assignment(policy) << "\n";
+    }
+    return 0;
+}
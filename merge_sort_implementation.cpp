@@ -1,8 +1,16 @@
 #include "random_mt.h"
+#include "workload_generator.h"
 
+#include <algorithm>
+#include <barrier>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstdlib>
 #include <iostream>
+#include <span>
+#include <string_view>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -14,6 +22,17 @@ template <typename T> class Sort {
     std::vector<T> buffer{};
 
     static constexpr int CUTOFF{7};
+    // Below this many elements a range is sorted or merged on one thread; starting a thread
+    // costs about as much as sorting this many ints
+    static constexpr int PARALLEL_CUTOFF{1 << 15};
+    // natural_merge_sort switches to galloping after this many wins in a row by one side
+    static constexpr int MIN_GALLOP{7};
+
+    // A sorted stretch data[base..base + length) waiting on natural_merge_sort's run stack
+    struct Run {
+        int base{};
+        int length{};
+    };
 
     void merge(int lo, int mid, int hi) {
         assert(lo >= 0 && hi < static_cast<int>(data.size()) && lo <= hi);
@@ -87,6 +106,432 @@ template <typename T> class Sort {
         merge(lo, mid, hi);
     }
 
+    // The number of elements of data[lo..mid] among the first k of the merge of data[lo..mid]
+    // and data[mid + 1..hi] (its "co-rank"), found by binary search. Ties go to the left half,
+    // as in merge().
+    int co_rank(int k, int lo, int mid, int hi) {
+        int left_size{mid - lo + 1};
+        int right_size{hi - mid};
+        int low{std::max(0, k - right_size)};
+        int high{std::min(k, left_size)};
+        while (low < high) {
+            int i{low + (high - low) / 2};
+            int j{k - i};
+            // data[lo + i] comes before data[mid + j], so more than i of the first k are left
+            if (j > 0 && !less_than(data[mid + j], data[lo + i])) {
+                low = i + 1;
+            } else {
+                high = i;
+            }
+        }
+        return low;
+    }
+
+    // Merges data[i..left_end) and data[j..right_end) into buffer[k..]
+    void merge_part(int i, int left_end, int j, int right_end, int k) {
+        while (i < left_end && j < right_end) {
+            if (less_than(data[j], data[i])) {
+                buffer[k++] = data[j++];
+            } else {
+                buffer[k++] = data[i++];
+            }
+        }
+        while (i < left_end) {
+            buffer[k++] = data[i++];
+        }
+        while (j < right_end) {
+            buffer[k++] = data[j++];
+        }
+    }
+
+    // How many of `threads` are worth starting on `size` elements: one per PARALLEL_CUTOFF
+    static unsigned useful_threads(long long size, unsigned threads) {
+        return static_cast<unsigned>(std::min<long long>(threads, size / PARALLEL_CUTOFF));
+    }
+
+    // merge() split over `threads` threads: the output is cut into equal parts, and co_rank
+    // tells each thread which stretch of either half makes up its part (the "merge path").
+    // Every thread copies its part back only once all of them are done reading data.
+    void parallel_merge(int lo, int mid, int hi, unsigned threads) {
+        long long size{hi - lo + 1};
+        threads = useful_threads(size, threads);
+        if (threads <= 1) {
+            merge(lo, mid, hi);
+            return;
+        }
+        std::barrier merged{static_cast<std::ptrdiff_t>(threads)};
+        auto merge_share{[this, lo, mid, hi, size, threads, &merged](unsigned part) {
+            auto first{static_cast<int>(size * part / threads)};
+            auto last{static_cast<int>(size * (part + 1) / threads)};
+            int left{co_rank(first, lo, mid, hi)};
+            int left_end{co_rank(last, lo, mid, hi)};
+            merge_part(lo + left, lo + left_end, mid + 1 + (first - left),
+                       mid + 1 + (last - left_end), lo + first);
+            merged.arrive_and_wait();
+            std::copy(buffer.begin() + lo + first, buffer.begin() + lo + last,
+                      data.begin() + lo + first);
+        }};
+
+        std::vector<std::thread> pool{};
+        for (unsigned part{1}; part < threads; ++part) {
+            pool.emplace_back(merge_share, part);
+        }
+        merge_share(0);
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+
+    // sort() with the left half handed to a new thread while this one does the right half,
+    // and the two merged by parallel_merge, for as long as there are threads to spare
+    void parallel_sort(int lo, int hi, unsigned threads) {
+        threads = useful_threads(hi - lo + 1, threads);
+        if (threads <= 1) {
+            sort(lo, hi);
+            return;
+        }
+
+        int mid{lo + (hi - lo) / 2};
+        unsigned left_threads{threads / 2};
+        std::thread left{[this, lo, mid, left_threads] { parallel_sort(lo, mid, left_threads); }};
+        parallel_sort(mid + 1, hi, threads - left_threads);
+        left.join();
+        parallel_merge(lo, mid, hi, threads);
+    }
+
+    // Merges src[lo..mid) and src[mid..hi) into dst[lo..hi)
+    void merge_runs(const T* src, T* dst, int lo, int mid, int hi) {
+        int i{lo}, j{mid}, k{lo};
+        while (i < mid && j < hi) {
+            if (less_than(src[j], src[i])) {
+                dst[k++] = src[j++];
+            } else {
+                dst[k++] = src[i++];
+            }
+        }
+        while (i < mid) {
+            dst[k++] = src[i++];
+        }
+        while (j < hi) {
+            dst[k++] = src[j++];
+        }
+    }
+
+    // TimSort's minimum run length for n elements: between 32 and 64, and chosen so that n / it
+    // is a power of two or just under, which keeps the final merges balanced
+    static int min_run_length(int size) {
+        int odd{};
+        while (size >= 64) {
+            odd |= size & 1;
+            size >>= 1;
+        }
+        return size + odd;
+    }
+
+    // The end of the run starting at lo: non-descending, or strictly descending and then
+    // reversed (strictly, so that reversing it never reorders equal elements)
+    int count_run(int lo, int hi) {
+        int end{lo + 1};
+        if (end == hi) {
+            return hi;
+        }
+        if (less_than(data[end], data[lo])) {
+            while (++end < hi && less_than(data[end], data[end - 1])) {
+            }
+            std::reverse(data.begin() + lo, data.begin() + end);
+        } else {
+            while (++end < hi && !less_than(data[end], data[end - 1])) {
+            }
+        }
+        return end;
+    }
+
+    // Sorts data[lo..hi) whose data[lo..sorted) is already sorted. Each element's place is
+    // found by binary search (after any equal ones, to keep the sort stable).
+    void binary_insertion_sort(int lo, int hi, int sorted) {
+        for (int i{sorted}; i < hi; ++i) {
+            T value{data[i]};
+            int left{lo}, right{i};
+            while (left < right) {
+                int mid{left + (right - left) / 2};
+                if (less_than(value, data[mid])) {
+                    right = mid;
+                } else {
+                    left = mid + 1;
+                }
+            }
+            std::copy_backward(data.begin() + left, data.begin() + i, data.begin() + i + 1);
+            data[left] = value;
+        }
+    }
+
+    // The gallop step after `offset`, 2 * offset + 1, capped at max_offset. Worked out in long long
+    // so that runs over 2^30 elements can't overflow int before the cap.
+    static int next_gallop(int offset, int max_offset) {
+        return static_cast<int>(std::min(2LL * offset + 1, static_cast<long long>(max_offset)));
+    }
+
+    // The k in [0, length] with a[k - 1] < key <= a[k], searched from a[hint] outwards in steps
+    // of 1, 3, 7, 15, ... and then by binary search: O(log distance) instead of O(log length)
+    int gallop_left(const T& key, const T* a, int length, int hint) {
+        int last_offset{}, offset{1};
+        if (less_than(a[hint], key)) {
+            int max_offset{length - hint};
+            while (offset < max_offset && less_than(a[hint + offset], key)) {
+                last_offset = offset;
+                offset = next_gallop(offset, max_offset);
+            }
+            offset = std::min(offset, max_offset);
+            last_offset += hint;
+            offset += hint;
+        } else {
+            int max_offset{hint + 1};
+            while (offset < max_offset && !less_than(a[hint - offset], key)) {
+                last_offset = offset;
+                offset = next_gallop(offset, max_offset);
+            }
+            offset = std::min(offset, max_offset);
+            int lower{hint - offset};
+            offset = hint - last_offset;
+            last_offset = lower;
+        }
+        // a[last_offset] < key <= a[offset], with a[-1] and a[length] as minus and plus infinity
+        ++last_offset;
+        while (last_offset < offset) {
+            int mid{last_offset + (offset - last_offset) / 2};
+            if (less_than(a[mid], key)) {
+                last_offset = mid + 1;
+            } else {
+                offset = mid;
+            }
+        }
+        return offset;
+    }
+
+    // The k in [0, length] with a[k - 1] <= key < a[k], found the same way
+    int gallop_right(const T& key, const T* a, int length, int hint) {
+        int last_offset{}, offset{1};
+        if (less_than(key, a[hint])) {
+            int max_offset{hint + 1};
+            while (offset < max_offset && less_than(key, a[hint - offset])) {
+                last_offset = offset;
+                offset = next_gallop(offset, max_offset);
+            }
+            offset = std::min(offset, max_offset);
+            int lower{hint - offset};
+            offset = hint - last_offset;
+            last_offset = lower;
+        } else {
+            int max_offset{length - hint};
+            while (offset < max_offset && !less_than(key, a[hint + offset])) {
+                last_offset = offset;
+                offset = next_gallop(offset, max_offset);
+            }
+            offset = std::min(offset, max_offset);
+            last_offset += hint;
+            offset += hint;
+        }
+        ++last_offset;
+        while (last_offset < offset) {
+            int mid{last_offset + (offset - last_offset) / 2};
+            if (less_than(key, a[mid])) {
+                offset = mid;
+            } else {
+                last_offset = mid + 1;
+            }
+        }
+        return offset;
+    }
+
+    // Merges the adjacent runs A = data[base_a..base_b) and B = data[base_b..base_b + length_b)
+    // with A no longer than B, B[0] < A[0] and A's last element above all of B. A is moved to
+    // buffer and the merge fills data from the front. Once one side has won min_gallop times in
+    // a row, the merge gallops: it searches for where the other side's next element goes and
+    // moves the whole stretch before it at once. min_gallop goes down while that pays off and
+    // up when it doesn't.
+    void merge_lo(int base_a, int length_a, int base_b, int length_b, int& min_gallop) {
+        std::copy(data.begin() + base_a, data.begin() + base_b, buffer.begin() + base_a);
+        const T* a{buffer.data() + base_a};
+        const T* b{data.data() + base_b};
+        T* dest{data.data() + base_a};
+
+        *dest++ = *b++;
+        --length_b;
+        while (length_b > 0 && length_a > 1) {
+            int count_a{}, count_b{};
+            while (length_b > 0 && length_a > 1 && count_a < min_gallop && count_b < min_gallop) {
+                if (less_than(*b, *a)) {
+                    *dest++ = *b++;
+                    --length_b;
+                    ++count_b;
+                    count_a = 0;
+                } else {
+                    *dest++ = *a++;
+                    --length_a;
+                    ++count_a;
+                    count_b = 0;
+                }
+            }
+
+            ++min_gallop;
+            while (length_b > 0 && length_a > 1) {
+                min_gallop -= min_gallop > 1;
+                count_a = gallop_right(*b, a, length_a, 0);
+                dest = std::copy(a, a + count_a, dest);
+                a += count_a;
+                length_a -= count_a;
+                if (length_a == 1) {
+                    break;
+                }
+                *dest++ = *b++;
+                if (--length_b == 0) {
+                    break;
+                }
+
+                count_b = gallop_left(*a, b, length_b, 0);
+                dest = std::copy(b, b + count_b, dest);
+                b += count_b;
+                length_b -= count_b;
+                if (length_b == 0) {
+                    break;
+                }
+                *dest++ = *a++;
+                if (--length_a == 1) {
+                    break;
+                }
+                if (count_a < MIN_GALLOP && count_b < MIN_GALLOP) {
+                    ++min_gallop;
+                    break;
+                }
+            }
+        }
+
+        if (length_a == 1) {
+            // A's last element is the largest of all
+            dest = std::copy(b, b + length_b, dest);
+            *dest = *a;
+        } else {
+            std::copy(a, a + length_a, dest);
+        }
+    }
+
+    // merge_lo's mirror image for A longer than B: B is moved to buffer and the merge fills
+    // data from the back
+    void merge_hi(int base_a, int length_a, int base_b, int length_b, int& min_gallop) {
+        std::copy(data.begin() + base_b, data.begin() + base_b + length_b,
+                  buffer.begin() + base_b);
+        const T* a{data.data() + base_a + length_a - 1};
+        const T* b{buffer.data() + base_b + length_b - 1};
+        T* dest{data.data() + base_b + length_b - 1};
+
+        *dest-- = *a--;
+        --length_a;
+        while (length_a > 0 && length_b > 1) {
+            int count_a{}, count_b{};
+            while (length_a > 0 && length_b > 1 && count_a < min_gallop && count_b < min_gallop) {
+                if (less_than(*b, *a)) {
+                    *dest-- = *a--;
+                    --length_a;
+                    ++count_a;
+                    count_b = 0;
+                } else {
+                    *dest-- = *b--;
+                    --length_b;
+                    ++count_b;
+                    count_a = 0;
+                }
+            }
+
+            ++min_gallop;
+            while (length_a > 0 && length_b > 1) {
+                min_gallop -= min_gallop > 1;
+                count_a = length_a - gallop_right(*b, a - length_a + 1, length_a, length_a - 1);
+                std::copy_backward(a - count_a + 1, a + 1, dest + 1);
+                a -= count_a;
+                dest -= count_a;
+                length_a -= count_a;
+                if (length_a == 0) {
+                    break;
+                }
+                *dest-- = *b--;
+                if (--length_b == 1) {
+                    break;
+                }
+
+                count_b = length_b - gallop_left(*a, b - length_b + 1, length_b, length_b - 1);
+                std::copy_backward(b - count_b + 1, b + 1, dest + 1);
+                b -= count_b;
+                dest -= count_b;
+                length_b -= count_b;
+                if (length_b == 1) {
+                    break;
+                }
+                *dest-- = *a--;
+                if (--length_a == 0) {
+                    break;
+                }
+                if (count_a < MIN_GALLOP && count_b < MIN_GALLOP) {
+                    ++min_gallop;
+                    break;
+                }
+            }
+        }
+
+        if (length_b == 1) {
+            // B's first element is the smallest of all
+            std::copy_backward(a - length_a + 1, a + 1, dest + 1);
+            dest -= length_a;
+            *dest = *b;
+        } else {
+            std::copy(b - length_b + 1, b + 1, dest - length_b + 1);
+        }
+    }
+
+    // Merges runs[i] and runs[i + 1]. The parts of A already below all of B and of B already
+    // above all of A stay where they are, and only the rest is merged.
+    void merge_at(std::vector<Run>& runs, std::size_t i, int& min_gallop) {
+        int base_a{runs[i].base}, length_a{runs[i].length};
+        int base_b{runs[i + 1].base}, length_b{runs[i + 1].length};
+        runs[i].length = length_a + length_b;
+        runs.erase(runs.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+
+        int skip{gallop_right(data[base_b], data.data() + base_a, length_a, 0)};
+        base_a += skip;
+        length_a -= skip;
+        if (length_a == 0) {
+            return;
+        }
+        length_b = gallop_left(data[base_b - 1], data.data() + base_b, length_b, length_b - 1);
+        if (length_b == 0) {
+            return;
+        }
+        if (length_a <= length_b) {
+            merge_lo(base_a, length_a, base_b, length_b, min_gallop);
+        } else {
+            merge_hi(base_a, length_a, base_b, length_b, min_gallop);
+        }
+    }
+
+    // Merges runs off the top of the stack until, reading down from the top, each run is
+    // longer than the one above it and than the two above it together. The lengths then grow
+    // at least like the Fibonacci numbers, so the stack stays O(log n) deep and each merge is
+    // of runs of similar length. (The check two runs down is the fix from de Gouw et al.,
+    // "OpenJDK's java.utils.Collection.sort() is broken", 2015.)
+    void merge_collapse(std::vector<Run>& runs, int& min_gallop) {
+        while (runs.size() > 1) {
+            std::size_t n{runs.size() - 2};
+            if ((n > 0 && runs[n - 1].length <= runs[n].length + runs[n + 1].length) ||
+                (n > 1 && runs[n - 2].length <= runs[n - 1].length + runs[n].length)) {
+                if (runs[n - 1].length < runs[n + 1].length) {
+                    --n;
+                }
+            } else if (runs[n].length > runs[n + 1].length) {
+                return;
+            }
+            merge_at(runs, n, min_gallop);
+        }
+    }
+
   public:
     Sort() = default;
 
@@ -102,6 +547,77 @@ template <typename T> class Sort {
         }
     }
 
+    // merge_sort() on `threads` threads (0 means one per hardware thread). The halves and
+    // their merges only touch their own part of data and buffer, so no locks are needed.
+    void parallel_merge_sort(unsigned threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        if (!data.empty()) {
+            parallel_sort(0, static_cast<int>(data.size()) - 1, threads);
+        }
+    }
+
+    // merge_sort() without recursion and without the copy back: runs of CUTOFF elements are
+    // sorted in place, then each pass merges pairs of runs from data into buffer, or from
+    // buffer into data, and the two swap roles for the next pass. Every element is read and
+    // written once per pass instead of twice, and if the last pass ends up in buffer the
+    // vectors are swapped. The merges within a pass are independent of each other.
+    void bottom_up_merge_sort() {
+        int size{static_cast<int>(data.size())};
+        for (int lo{}; lo < size; lo += CUTOFF) {
+            selection_sort(lo, std::min(lo + CUTOFF, size) - 1);
+        }
+
+        T* src{data.data()};
+        T* dst{buffer.data()};
+        for (int width{CUTOFF}; width < size; width *= 2) {
+            for (int lo{}; lo < size; lo += 2 * width) {
+                int mid{std::min(lo + width, size)};
+                int hi{std::min(lo + 2 * width, size)};
+                merge_runs(src, dst, lo, mid, hi);
+            }
+            std::swap(src, dst);
+        }
+        if (src != data.data()) {
+            data.swap(buffer);
+        }
+    }
+
+    // An adaptive merge sort after TimSort (Tim Peters, Python's listsort.txt): it looks for
+    // the runs already in the data, ascending or strictly descending (those are reversed), and
+    // only merges them. Runs shorter than 32..64 elements are extended with binary insertion
+    // sort. Merges gallop through stretches that are already in order, so sorted input takes
+    // n - 1 comparisons and a sorted array with a short unsorted tail takes little more.
+    void natural_merge_sort() {
+        int size{static_cast<int>(data.size())};
+        if (size < 2) {
+            return;
+        }
+
+        int min_run{min_run_length(size)};
+        int min_gallop{MIN_GALLOP};
+        std::vector<Run> runs{};
+        for (int lo{}; lo < size;) {
+            int hi{count_run(lo, size)};
+            if (hi - lo < min_run) {
+                int forced{std::min(lo + min_run, size)};
+                binary_insertion_sort(lo, forced, hi);
+                hi = forced;
+            }
+            runs.push_back(Run{lo, hi - lo});
+            merge_collapse(runs, min_gallop);
+            lo = hi;
+        }
+        while (runs.size() > 1) {
+            std::size_t n{runs.size() - 2};
+            if (n > 0 && runs[n - 1].length < runs[n + 1].length) {
+                --n;
+            }
+            merge_at(runs, n, min_gallop);
+        }
+    }
+
     void resize(int size) {
         assert(size >= 0);
         data.resize(static_cast<std::size_t>(size));
@@ -128,12 +644,80 @@ template <typename T> class Sort {
     }
 };
 
-int main() {
+// Times parallel_merge_sort on 1, 2, 4, ... threads up to the hardware thread count, and
+// bottom_up_merge_sort, all against parallel_merge_sort on 1 thread
+template <typename T> void scaling_benchmark(std::string_view type, int size) {
+    std::vector<T> unsorted_data(static_cast<std::size_t>(size));
+    Random::fill_uniform(std::span{unsorted_data});
+
+    double one_thread_ms{};
+    auto run{[&](std::string_view sort, unsigned threads, auto sort_data) {
+        Sort<T> data{unsorted_data};
+        auto start{std::chrono::steady_clock::now()};
+        sort_data(data);
+        std::chrono::duration<double, std::milli> elapsed{std::chrono::steady_clock::now() - start};
+        if (one_thread_ms == 0) {
+            one_thread_ms = elapsed.count();
+        }
+        std::cout << type << "\t" << sort << "\t" << threads << "\t" << elapsed.count() << "\t"
+                  << one_thread_ms / elapsed.count() << (data.is_sorted() ? "" : "\tNOT SORTED")
+                  << "\n";
+    }};
+
+    unsigned hardware_threads{std::max(1u, std::thread::hardware_concurrency())};
+    for (unsigned threads{1}; threads <= hardware_threads; threads *= 2) {
+        run("top_down", threads, [threads](Sort<T>& data) { data.parallel_merge_sort(threads); });
+    }
+    run("bottom_up", 1, [](Sort<T>& data) { data.bottom_up_merge_sort(); });
+}
+
+// Times natural_merge_sort against merge_sort on every Workload shape, and on sorted data with
+// 1% of random values appended
+void adaptive_benchmark(int size) {
+    auto time_ms{[](std::vector<int>& unsorted_data, auto sort_data) {
+        Sort<int> data{unsorted_data};
+        auto start{std::chrono::steady_clock::now()};
+        sort_data(data);
+        std::chrono::duration<double, std::milli> elapsed{std::chrono::steady_clock::now() - start};
+        return data.is_sorted() ? elapsed.count() : -1.0;
+    }};
+    auto compare{[&](std::string_view shape, std::vector<int>& unsorted_data) {
+        double top_down_ms{time_ms(unsorted_data, [](Sort<int>& data) { data.merge_sort(); })};
+        double natural_ms{
+            time_ms(unsorted_data, [](Sort<int>& data) { data.natural_merge_sort(); })};
+        std::cout << shape << "\t" << top_down_ms << "\t" << natural_ms << "\t"
+                  << top_down_ms / natural_ms << "\n";
+    }};
+
+    std::cout << "shape\ttop_down ms\tnatural ms\tspeedup\n";
+    std::vector<int> unsorted_data(static_cast<std::size_t>(size));
+    for (auto shape : Workload::all_shapes) {
+        Workload::fill(std::span{unsorted_data}, shape);
+        compare(Workload::name(shape), unsorted_data);
+    }
+    std::size_t tail{unsorted_data.size() / 100};
+    Workload::fill(std::span{unsorted_data}, Workload::Shape::uniform);
+    std::sort(unsorted_data.begin(), unsorted_data.end() - static_cast<std::ptrdiff_t>(tail));
+    compare("sorted_plus_tail", unsorted_data);
+}
+
+// ./merge_sort                 sorts and prints 20 random ints
+// ./merge_sort --bench [size]  thread scaling of parallel_merge_sort, and bottom_up_merge_sort,
+//                              on `size` (default 10^8) ints and doubles, then
+//                              natural_merge_sort against merge_sort on every input shape
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view{argv[1]} == "--bench") {
+        int size{argc > 2 ? std::atoi(argv[2]) : 100'000'000};
+        std::cout << "type\tsort\tthreads\tms\tspeedup\n";
+        scaling_benchmark<int>("int", size);
+        scaling_benchmark<double>("double", size);
+        adaptive_benchmark(size);
+        return 0;
+    }
+
     std::size_t size{20};
     std::vector<int> unsorted_data(size);
-    for (std::size_t i{}; i < size; ++i) {
-        unsorted_data[i] = Random::get(0, size);
-    }
+    Random::fill(std::span{unsorted_data}, 0, static_cast<int>(size));
     Sort<int> data{unsorted_data};
     data.merge_sort();
     data.print();
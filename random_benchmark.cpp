@@ -0,0 +1,290 @@
+/*
+  File: random_benchmark.cpp
+
+  Throughput and a quick quality check for every engine and distribution in the Random namespace,
+  so an engine can be picked from numbers instead of guesses.
+
+  Build:
+    g++ -std=c++20 -O2 -march=native -Wall -Wextra random_benchmark.cpp -o random_bench -pthread
+
+  Run:
+    ./random_bench                # 2^24 values per thread and case
+    ./random_bench 1000000        # fewer values for a quick look
+
+  Output is one JSON document on stdout:
+    "throughput": ns per value and GB/s of output, for every engine x distribution, on 1 thread
+                  and on every hardware thread (each thread has its own engine, seeded apart)
+    "seeding":    ns to build one engine with Random::generate<E>() and Random::generate_fast<E>()
+    "quality":    per engine, a chi-squared test of the top 8 bits over 256 buckets (255 degrees
+                  of freedom, so roughly 180..335 is fine) and the lag-1 serial correlation of
+                  [0, 1) values (should be within a few times 1 / sqrt(samples) of 0)
+  This is a smoke test only. Use TestU01 or PractRand to judge an engine properly.
+*/
+
+#include "random_mt.h"
+#include "ziggurat.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Throughput {
+    std::string engine{};
+    std::string distribution{};
+    unsigned threads{};
+    double ns_per_value{};
+    double gb_per_second{};
+};
+
+struct Seeding {
+    std::string engine{};
+    std::string call{};
+    double ns_per_engine{};
+};
+
+struct Quality {
+    std::string engine{};
+    double chi_squared{};
+    double serial_correlation{};
+    std::size_t samples{};
+};
+
+// Runs work(thread_index) on `threads` threads at once and returns the wall time in nanoseconds
+double time_threads(unsigned threads, const std::function<void(unsigned)>& work) {
+    std::vector<std::thread> pool{};
+    auto start{std::chrono::steady_clock::now()};
+    for (unsigned thread{1}; thread < threads; ++thread) {
+        pool.emplace_back(work, thread);
+    }
+    work(0);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Keeps the optimizer from throwing away results that are never looked at
+std::atomic<std::uint64_t> sink{};
+
+template <typename Engine> class EngineBenchmark {
+  public:
+    EngineBenchmark(std::string name, std::size_t values, std::vector<Throughput>& results)
+        : m_name{std::move(name)}, m_values{values}, m_results{results} {}
+
+    void run(unsigned threads) {
+        // one value at a time
+        scalar(threads, "bits", sizeof(typename Engine::result_type),
+               [](Engine& rng) { return static_cast<std::uint64_t>(rng()); });
+        scalar(threads, "get(0, 999)", sizeof(int),
+               [](Engine& rng) { return static_cast<std::uint64_t>(Random::get(rng, 0, 999)); });
+        scalar(threads, "std::uniform_int_distribution", sizeof(int), [](Engine& rng) {
+            return static_cast<std::uint64_t>(std::uniform_int_distribution{0, 999}(rng));
+        });
+        scalar(threads, "random<double>", sizeof(double), [](Engine& rng) {
+            return static_cast<std::uint64_t>(Random::random<double>(rng) * 1000);
+        });
+        scalar(threads, "normal", sizeof(double), [](Engine& rng) {
+            return static_cast<std::uint64_t>(Random::normal(rng) * 1000);
+        });
+        scalar(threads, "std::normal_distribution", sizeof(double), [](Engine& rng) {
+            return static_cast<std::uint64_t>(std::normal_distribution<double>{}(rng) * 1000);
+        });
+        scalar(threads, "exponential", sizeof(double), [](Engine& rng) {
+            return static_cast<std::uint64_t>(Random::exponential(rng) * 1000);
+        });
+
+        // whole buffers
+        bulk<int>(threads, "fill(0, 999)",
+                  [](Engine& rng, std::span<int> out) { Random::fill(rng, out, 0, 999); });
+        bulk<double>(threads, "fill_uniform<double>",
+                     [](Engine& rng, std::span<double> out) { Random::fill_uniform(rng, out); });
+        bulk<float>(threads, "fill_uniform<float>",
+                    [](Engine& rng, std::span<float> out) { Random::fill_uniform(rng, out); });
+        bulk<double>(threads, "fill_normal",
+                     [](Engine& rng, std::span<double> out) { Random::fill_normal(rng, out); });
+        bulk<double>(threads, "fill_exponential", [](Engine& rng, std::span<double> out) {
+            Random::fill_exponential(rng, out);
+        });
+    }
+
+    // The cost of Random::generate<Engine>() and Random::generate_fast<Engine>(), on one thread
+    std::vector<Seeding> seeding(int repeats) const {
+        auto time_ns{[repeats](auto make) {
+            auto start{std::chrono::steady_clock::now()};
+            for (int i{}; i < repeats; ++i) {
+                Engine rng{make()};
+                sink += static_cast<std::uint64_t>(rng());
+            }
+            std::chrono::duration<double, std::nano> elapsed{std::chrono::steady_clock::now() -
+                                                             start};
+            return elapsed.count() / repeats;
+        }};
+        return {
+            Seeding{m_name, "generate", time_ns([] { return Random::generate<Engine>(); })},
+            Seeding{m_name, "generate_fast",
+                    time_ns([] { return Random::generate_fast<Engine>(); })},
+        };
+    }
+
+    Quality quality(std::size_t samples) const {
+        Engine rng{seeded(0)};
+        std::vector<double> buckets(256);
+        double previous{Random::to_unit<double>(Random::detail::next_u64(rng))};
+        double sum{};
+        double sum_squares{};
+        double sum_products{};
+
+        for (std::size_t i{}; i < samples; ++i) {
+            std::uint64_t bits{Random::detail::next_u64(rng)};
+            buckets[bits >> 56] += 1;
+
+            double value{Random::to_unit<double>(bits)};
+            sum += value;
+            sum_squares += value * value;
+            sum_products += previous * value;
+            previous = value;
+        }
+
+        double expected{static_cast<double>(samples) / 256};
+        double chi_squared{};
+        for (double count : buckets) {
+            chi_squared += (count - expected) * (count - expected) / expected;
+        }
+        double n{static_cast<double>(samples)};
+        double mean{sum / n};
+        double variance{sum_squares / n - mean * mean};
+        return Quality{m_name, chi_squared, (sum_products / n - mean * mean) / variance, samples};
+    }
+
+  private:
+    std::string m_name{};
+    std::size_t m_values{};
+    std::vector<Throughput>& m_results;
+
+    static Engine seeded(unsigned thread) {
+        // every thread gets its own stream off one fixed root, so runs are repeatable
+        std::seed_seq seq{20240601U, thread};
+        return Engine{seq};
+    }
+
+    void record(std::string distribution, unsigned threads, std::size_t bytes, double ns) {
+        double values{static_cast<double>(m_values) * threads};
+        m_results.push_back(Throughput{m_name, std::move(distribution), threads, ns / values,
+                                       values * static_cast<double>(bytes) / ns});
+    }
+
+    template <typename Draw>
+    void scalar(unsigned threads, std::string distribution, std::size_t bytes, Draw draw) {
+        double ns{time_threads(threads, [&](unsigned thread) {
+            Engine rng{seeded(thread)};
+            std::uint64_t total{};
+            for (std::size_t i{}; i < m_values; ++i) {
+                total += draw(rng);
+            }
+            sink += total;
+        })};
+        record(std::move(distribution), threads, bytes, ns);
+    }
+
+    template <typename T, typename Fill>
+    void bulk(unsigned threads, std::string distribution, Fill fill) {
+        // Buffers are allocated and touched before the clock starts
+        std::vector<std::vector<T>> buffers(threads, std::vector<T>(m_values));
+        double ns{time_threads(threads, [&](unsigned thread) {
+            Engine rng{seeded(thread)};
+            fill(rng, std::span<T>{buffers[thread]});
+            sink += static_cast<std::uint64_t>(buffers[thread].back());
+        })};
+        record(std::move(distribution), threads, sizeof(T), ns);
+    }
+};
+
+template <typename Engine>
+void benchmark_engine(const std::string& name, std::size_t values, std::vector<unsigned> threads,
+                      std::vector<Throughput>& throughput, std::vector<Seeding>& seeding,
+                      std::vector<Quality>& quality) {
+    EngineBenchmark<Engine> benchmark{name, values, throughput};
+    for (unsigned count : threads) {
+        benchmark.run(count);
+    }
+    for (auto& row : benchmark.seeding(1000)) {
+        seeding.push_back(std::move(row));
+    }
+    quality.push_back(benchmark.quality(std::size_t{1} << 22));
+}
+
+void print_json(const std::vector<Throughput>& throughput, const std::vector<Seeding>& seeding,
+                const std::vector<Quality>& quality) {
+    std::cout << "{\n  \"throughput\": [\n";
+    for (std::size_t i{}; i < throughput.size(); ++i) {
+        const auto& row{throughput[i]};
+        std::cout << "    {\"engine\": \"" << row.engine << "\", \"distribution\": \""
+                  << row.distribution << "\", \"threads\": " << row.threads
+                  << ", \"ns_per_value\": " << row.ns_per_value
+                  << ", \"gb_per_s\": " << row.gb_per_second << "}"
+                  << (i + 1 < throughput.size() ? ",\n" : "\n");
+    }
+    std::cout << "  ],\n  \"seeding\": [\n";
+    for (std::size_t i{}; i < seeding.size(); ++i) {
+        const auto& row{seeding[i]};
+        std::cout << "    {\"engine\": \"" << row.engine << "\", \"call\": \"" << row.call
+                  << "\", \"ns_per_engine\": " << row.ns_per_engine << "}"
+                  << (i + 1 < seeding.size() ? ",\n" : "\n");
+    }
+    std::cout << "  ],\n  \"quality\": [\n";
+    for (std::size_t i{}; i < quality.size(); ++i) {
+        const auto& row{quality[i]};
+        std::cout << "    {\"engine\": \"" << row.engine << "\", \"samples\": " << row.samples
+                  << ", \"chi_squared_255\": " << row.chi_squared
+                  << ", \"serial_correlation\": " << row.serial_correlation << "}"
+                  << (i + 1 < quality.size() ? ",\n" : "\n");
+    }
+    std::cout << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t values{std::size_t{1} << 24};
+    if (argc > 1) {
+        char* end{nullptr};
+        values = std::strtoull(argv[1], &end, 10);
+        if (argv[1][0] < '0' || argv[1][0] > '9' || *end != '\0' || values == 0) {
+            std::cerr << "usage: " << argv[0] << " [values per thread and case, at least 1]\n";
+            return 1;
+        }
+    }
+
+    std::vector<unsigned> threads{1};
+    if (unsigned cores{std::thread::hardware_concurrency()}; cores > 1) {
+        threads.push_back(cores);
+    }
+
+    std::vector<Throughput> throughput{};
+    std::vector<Seeding> seeding{};
+    std::vector<Quality> quality{};
+    benchmark_engine<std::mt19937>("mt19937", values, threads, throughput, seeding, quality);
+    benchmark_engine<std::mt19937_64>("mt19937_64", values, threads, throughput, seeding, quality);
+    benchmark_engine<Random::Xoshiro256StarStar>("xoshiro256**", values, threads, throughput,
+                                                 seeding, quality);
+    benchmark_engine<Random::Xoshiro256StarStarX4>("xoshiro256**x4", values, threads, throughput,
+                                                   seeding, quality);
+    benchmark_engine<Random::Xoshiro256StarStarX8>("xoshiro256**x8", values, threads, throughput,
+                                                   seeding, quality);
+#ifdef __SIZEOF_INT128__
+    benchmark_engine<Random::Pcg64>("pcg64", values, threads, throughput, seeding, quality);
+#endif
+    benchmark_engine<Random::Philox4x32>("philox4x32", values, threads, throughput, seeding,
+                                         quality);
+
+    print_json(throughput, seeding, quality);
+    return 0;
+}
@@ -0,0 +1,459 @@
+#ifndef RANDOM_ENGINES_H
+#define RANDOM_ENGINES_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Small, fast engines for the Random namespace (see random_mt.h).
+// Every engine here is a UniformRandomBitGenerator producing full 64-bit words, so it works with
+// Random::get / Random::random / Random::fill and with the <random> distributions.
+// Like the standard engines, each one can be seeded from a single integer or from a std::seed_seq.
+namespace Random {
+namespace detail {
+// splitmix64: advances `state` by a fixed odd constant and returns a well mixed 64-bit value.
+// Consecutive outputs never repeat for 2^64 calls, so disjoint slices of the sequence can be
+// handed out as independent seeds.
+constexpr std::uint64_t splitmix64(std::uint64_t& state) noexcept {
+    std::uint64_t z{state += 0x9E3779B97F4A7C15ULL};
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 uint128;
+#endif
+
+// Anything with std::seed_seq's generate(first, last), the same thing the standard engines accept
+template <typename Sseq>
+concept SeedSequence = !std::is_arithmetic_v<Sseq> && requires(Sseq& seq, std::uint32_t* words) {
+    seq.generate(words, words);
+};
+
+// Pulls `Count` 64-bit words out of a seed sequence
+template <std::size_t Count, typename Sseq>
+std::array<std::uint64_t, Count> seed_words(Sseq& seq) {
+    std::array<std::uint32_t, 2 * Count> halves{};
+    seq.generate(halves.begin(), halves.end());
+
+    std::array<std::uint64_t, Count> words{};
+    for (std::size_t i{}; i < Count; ++i) {
+        words[i] = (std::uint64_t{halves[2 * i]} << 32) | halves[2 * i + 1];
+    }
+    return words;
+}
+} // namespace detail
+
+// xoshiro256** by Blackman and Vigna (https://prng.di.unimi.it/)
+// 32 bytes of state (std::mt19937 carries 2.5 KB), period 2^256 - 1, and a handful of
+// shifts, xors and rotates per 64-bit output.
+class Xoshiro256StarStar {
+  public:
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type{0}; }
+
+    constexpr Xoshiro256StarStar() : Xoshiro256StarStar(0x853C49E6748FEA9BULL) {}
+
+    constexpr explicit Xoshiro256StarStar(std::uint64_t value) { seed(value); }
+
+    template <detail::SeedSequence Sseq> explicit Xoshiro256StarStar(Sseq& seq) { seed(seq); }
+
+    // Expands one integer into the full state with splitmix64, as the authors recommend
+    constexpr void seed(std::uint64_t value) noexcept {
+        for (auto& word : m_state) {
+            word = detail::splitmix64(value);
+        }
+    }
+
+    template <detail::SeedSequence Sseq> void seed(Sseq& seq) {
+        m_state = detail::seed_words<4>(seq);
+        if ((m_state[0] | m_state[1] | m_state[2] | m_state[3]) == 0) {
+            // the all zero state is the one state the generator can never leave
+            seed(0);
+        }
+    }
+
+    constexpr result_type operator()() noexcept {
+        const result_type result{std::rotl(m_state[1] * 5, 7) * 9};
+        const result_type t{m_state[1] << 17};
+
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+
+        m_state[2] ^= t;
+        m_state[3] = std::rotl(m_state[3], 45);
+
+        return result;
+    }
+
+    constexpr void discard(unsigned long long count) noexcept {
+        for (; count > 0; --count) {
+            (*this)();
+        }
+    }
+
+    // Advances the state by 2^128 steps.
+    // Calling jump() n times on copies of one engine gives n streams that never overlap.
+    constexpr void jump() noexcept {
+        constexpr std::uint64_t polynomial[]{0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+                                             0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+        std::array<std::uint64_t, 4> jumped{};
+        for (std::uint64_t word : polynomial) {
+            for (int bit{}; bit < 64; ++bit) {
+                if (word & (std::uint64_t{1} << bit)) {
+                    for (std::size_t i{}; i < 4; ++i) {
+                        jumped[i] ^= m_state[i];
+                    }
+                }
+                (*this)();
+            }
+        }
+        m_state = jumped;
+    }
+
+    constexpr const std::array<std::uint64_t, 4>& state() const noexcept { return m_state; }
+
+    friend constexpr bool operator==(const Xoshiro256StarStar&,
+                                     const Xoshiro256StarStar&) = default;
+
+  private:
+    std::array<std::uint64_t, 4> m_state{};
+};
+
+#ifdef __SIZEOF_INT128__
+// PCG64 (XSL-RR 128/64) by Melissa O'Neill (https://www.pcg-random.org/)
+// A 128-bit LCG whose output is scrambled by an xor-shift and a data dependent rotate.
+// The increment picks one of 2^127 independent streams.
+class Pcg64 {
+  public:
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type{0}; }
+
+    constexpr Pcg64() : Pcg64(0xCAFEF00DD15EA5E5ULL) {}
+
+    constexpr explicit Pcg64(std::uint64_t value, std::uint64_t stream = 0) {
+        seed(value, stream);
+    }
+
+    template <detail::SeedSequence Sseq> explicit Pcg64(Sseq& seq) { seed(seq); }
+
+    constexpr void seed(std::uint64_t value, std::uint64_t stream = 0) noexcept {
+        std::uint64_t mix{value};
+        std::uint64_t state_high{detail::splitmix64(mix)};
+        std::uint64_t state_low{detail::splitmix64(mix)};
+        set_state((detail::uint128{state_high} << 64) | state_low,
+                  (detail::uint128{stream} << 64) | detail::splitmix64(mix));
+    }
+
+    template <detail::SeedSequence Sseq> void seed(Sseq& seq) {
+        auto words{detail::seed_words<4>(seq)};
+        set_state((detail::uint128{words[0]} << 64) | words[1],
+                  (detail::uint128{words[2]} << 64) | words[3]);
+    }
+
+    constexpr result_type operator()() noexcept {
+        step();
+        auto high{static_cast<std::uint64_t>(m_state >> 64)};
+        auto low{static_cast<std::uint64_t>(m_state)};
+        return std::rotr(high ^ low, static_cast<int>(m_state >> 122));
+    }
+
+    constexpr void discard(unsigned long long count) noexcept {
+        for (; count > 0; --count) {
+            step();
+        }
+    }
+
+    friend constexpr bool operator==(const Pcg64&, const Pcg64&) = default;
+
+  private:
+    static constexpr detail::uint128 multiplier{
+        (detail::uint128{0x2360ED051FC65DA4ULL} << 64) | 0x4385DF649FCCF645ULL};
+
+    detail::uint128 m_state{};
+    detail::uint128 m_increment{};
+
+    // Same initialisation as pcg_setseq_128_srandom_r in the reference implementation
+    constexpr void set_state(detail::uint128 initial_state, detail::uint128 sequence) noexcept {
+        m_state = 0;
+        m_increment = (sequence << 1) | 1; // the increment has to be odd
+        step();
+        m_state += initial_state;
+        step();
+    }
+
+    constexpr void step() noexcept { m_state = m_state * multiplier + m_increment; }
+};
+#endif // __SIZEOF_INT128__
+
+// Philox4x32-10 by Salmon et al. ("Parallel Random Numbers: As Easy as 1, 2, 3", SC11)
+// A counter-based engine: there is no evolving state, output n is a keyed bijection of n.
+// So value n of stream s can be computed directly, and seek()/discard() are O(1).
+// That makes parallel work reproducible: thread t seeks to the first index of its chunk and
+// then draws exactly what a single thread would have drawn there.
+//     Random::Philox4x32 rng{seed, stream};
+//     rng.seek(chunk_begin);
+//     for (std::size_t i{chunk_begin}; i < chunk_end; ++i) { out[i] = rng(); }
+// Each 128-bit block gives two 64-bit outputs, and one stream holds 2^64 of them.
+class Philox4x32 {
+  public:
+    using result_type = std::uint64_t;
+    using Block = std::array<std::uint32_t, 4>;
+    using Key = std::array<std::uint32_t, 2>;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type{0}; }
+
+    constexpr Philox4x32() : Philox4x32(0) {}
+
+    constexpr explicit Philox4x32(std::uint64_t value, std::uint64_t stream = 0) {
+        seed(value, stream);
+    }
+
+    template <detail::SeedSequence Sseq> explicit Philox4x32(Sseq& seq) { seed(seq); }
+
+    constexpr void seed(std::uint64_t value, std::uint64_t stream = 0) noexcept {
+        m_key = {static_cast<std::uint32_t>(value), static_cast<std::uint32_t>(value >> 32)};
+        m_stream = stream;
+        m_position = 0;
+    }
+
+    template <detail::SeedSequence Sseq> void seed(Sseq& seq) {
+        seed(detail::seed_words<1>(seq)[0]);
+    }
+
+    // The Philox bijection itself: ten rounds of multiply, swap and xor with a bumped key
+    static constexpr Block block(Block counter, Key key) noexcept {
+        for (int round{}; round < 10; ++round) {
+            if (round > 0) {
+                key[0] += 0x9E3779B9U;
+                key[1] += 0xBB67AE85U;
+            }
+            const std::uint64_t product_0{std::uint64_t{0xD2511F53U} * counter[0]};
+            const std::uint64_t product_1{std::uint64_t{0xCD9E8D57U} * counter[2]};
+
+            counter = {static_cast<std::uint32_t>(product_1 >> 32) ^ counter[1] ^ key[0],
+                       static_cast<std::uint32_t>(product_1),
+                       static_cast<std::uint32_t>(product_0 >> 32) ^ counter[3] ^ key[1],
+                       static_cast<std::uint32_t>(product_0)};
+        }
+        return counter;
+    }
+
+    // Value `index` of stream `stream` under `value`, without building an engine
+    static constexpr result_type at(std::uint64_t value, std::uint64_t stream,
+                                    std::uint64_t index) noexcept {
+        Block counter{static_cast<std::uint32_t>(index >> 1),
+                      static_cast<std::uint32_t>(index >> 33), static_cast<std::uint32_t>(stream),
+                      static_cast<std::uint32_t>(stream >> 32)};
+        Key key{static_cast<std::uint32_t>(value), static_cast<std::uint32_t>(value >> 32)};
+        Block out{block(counter, key)};
+
+        std::size_t half{(index & 1) * 2};
+        return (std::uint64_t{out[half + 1]} << 32) | out[half];
+    }
+
+    constexpr result_type operator()() noexcept {
+        if ((m_position & 1) == 0) {
+            m_block = block(counter_for(m_position), m_key);
+        }
+        std::size_t half{(m_position & 1) * 2};
+        ++m_position;
+        return (std::uint64_t{m_block[half + 1]} << 32) | m_block[half];
+    }
+
+    constexpr void discard(unsigned long long count) noexcept { seek(m_position + count); }
+
+    // Jumps straight to output `index` of the current stream
+    constexpr void seek(std::uint64_t index) noexcept {
+        m_position = index;
+        if (m_position & 1) {
+            // the next draw is the second half of a block we haven't computed yet
+            m_block = block(counter_for(m_position), m_key);
+        }
+    }
+
+    constexpr std::uint64_t position() const noexcept { return m_position; }
+
+    constexpr std::uint64_t stream() const noexcept { return m_stream; }
+
+    // Switches to another stream under the same key, starting from its first output
+    constexpr void set_stream(std::uint64_t stream) noexcept {
+        m_stream = stream;
+        seek(0);
+    }
+
+    friend constexpr bool operator==(const Philox4x32& lhs, const Philox4x32& rhs) noexcept {
+        return lhs.m_key == rhs.m_key && lhs.m_stream == rhs.m_stream &&
+               lhs.m_position == rhs.m_position;
+    }
+
+  private:
+    Key m_key{};
+    std::uint64_t m_stream{};
+    std::uint64_t m_position{}; // index of the next output in the stream
+    Block m_block{};            // the block holding outputs m_position & ~1 and its neighbour
+
+    constexpr Block counter_for(std::uint64_t index) const noexcept {
+        return {static_cast<std::uint32_t>(index >> 1), static_cast<std::uint32_t>(index >> 33),
+                static_cast<std::uint32_t>(m_stream), static_cast<std::uint32_t>(m_stream >> 32)};
+    }
+};
+
+// xoshiro256** run as Lanes independent generators side by side (Lanes is 4 or 8).
+// Each step produces a whole block of Lanes outputs. With AVX2 one block of four lanes is one
+// 256-bit register, otherwise the plain loop below is laid out so the compiler can vectorize it.
+// Lane n starts n jumps (n * 2^128 steps) after lane 0, so the lanes never overlap.
+// operator() hands the block out one word at a time; fill() skips that and writes whole blocks.
+template <std::size_t Lanes> class Xoshiro256StarStarLanes {
+    static_assert(Lanes == 4 || Lanes == 8, "Xoshiro256StarStarLanes supports 4 or 8 lanes");
+
+  public:
+    using result_type = std::uint64_t;
+
+    static constexpr std::size_t lanes{Lanes};
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type{0}; }
+
+    Xoshiro256StarStarLanes() : Xoshiro256StarStarLanes(0x853C49E6748FEA9BULL) {}
+
+    explicit Xoshiro256StarStarLanes(std::uint64_t value) { seed(value); }
+
+    template <detail::SeedSequence Sseq> explicit Xoshiro256StarStarLanes(Sseq& seq) {
+        seed(seq);
+    }
+
+    void seed(std::uint64_t value) { spread(Xoshiro256StarStar{value}); }
+
+    template <detail::SeedSequence Sseq> void seed(Sseq& seq) { spread(Xoshiro256StarStar{seq}); }
+
+    result_type operator()() {
+        if (m_used == Lanes) {
+            next_block(m_block);
+            m_used = 0;
+        }
+        return m_block[m_used++];
+    }
+
+    void discard(unsigned long long count) {
+        for (; count > 0; --count) {
+            (*this)();
+        }
+    }
+
+    // Writes one output from every lane into out
+    void next_block(std::uint64_t* out) noexcept {
+#ifdef __AVX2__
+        for (std::size_t lane{}; lane < Lanes; lane += 4) {
+            step_avx2(lane, out + lane);
+        }
+#else
+        for (std::size_t lane{}; lane < Lanes; ++lane) {
+            out[lane] = std::rotl(m_s1[lane] * 5, 7) * 9;
+            const std::uint64_t t{m_s1[lane] << 17};
+
+            m_s2[lane] ^= m_s0[lane];
+            m_s3[lane] ^= m_s1[lane];
+            m_s1[lane] ^= m_s2[lane];
+            m_s0[lane] ^= m_s3[lane];
+
+            m_s2[lane] ^= t;
+            m_s3[lane] = std::rotl(m_s3[lane], 45);
+        }
+#endif
+    }
+
+    // Fills out with whole blocks, finishing any partial block through operator()
+    void fill(std::span<std::uint64_t> out) noexcept {
+        std::size_t index{};
+        for (; m_used < Lanes && index < out.size(); ++index) {
+            out[index] = m_block[m_used++];
+        }
+        for (; index + Lanes <= out.size(); index += Lanes) {
+            next_block(out.data() + index);
+        }
+        for (; index < out.size(); ++index) {
+            out[index] = (*this)();
+        }
+    }
+
+  private:
+    // structure of arrays: word k of every lane's state sits in one contiguous row
+    alignas(32) std::uint64_t m_s0[Lanes]{};
+    alignas(32) std::uint64_t m_s1[Lanes]{};
+    alignas(32) std::uint64_t m_s2[Lanes]{};
+    alignas(32) std::uint64_t m_s3[Lanes]{};
+    alignas(32) std::uint64_t m_block[Lanes]{};
+    std::size_t m_used{Lanes}; // every word of m_block has been handed out
+
+    void spread(Xoshiro256StarStar scalar) noexcept {
+        for (std::size_t lane{}; lane < Lanes; ++lane) {
+            const auto& state{scalar.state()};
+            m_s0[lane] = state[0];
+            m_s1[lane] = state[1];
+            m_s2[lane] = state[2];
+            m_s3[lane] = state[3];
+            scalar.jump();
+        }
+        m_used = Lanes;
+    }
+
+#ifdef __AVX2__
+    template <int Bits> static __m256i rotl_avx2(__m256i x) noexcept {
+        return _mm256_or_si256(_mm256_slli_epi64(x, Bits), _mm256_srli_epi64(x, 64 - Bits));
+    }
+
+    // AVX2 has no 64-bit multiply, but x * 5 and x * 9 are just a shift and an add
+    void step_avx2(std::size_t lane, std::uint64_t* out) noexcept {
+        auto* p0{reinterpret_cast<__m256i*>(m_s0 + lane)};
+        auto* p1{reinterpret_cast<__m256i*>(m_s1 + lane)};
+        auto* p2{reinterpret_cast<__m256i*>(m_s2 + lane)};
+        auto* p3{reinterpret_cast<__m256i*>(m_s3 + lane)};
+
+        __m256i s0{_mm256_load_si256(p0)};
+        __m256i s1{_mm256_load_si256(p1)};
+        __m256i s2{_mm256_load_si256(p2)};
+        __m256i s3{_mm256_load_si256(p3)};
+
+        __m256i times_5{_mm256_add_epi64(_mm256_slli_epi64(s1, 2), s1)};
+        __m256i rotated{rotl_avx2<7>(times_5)};
+        __m256i result{_mm256_add_epi64(_mm256_slli_epi64(rotated, 3), rotated)};
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), result);
+
+        __m256i t{_mm256_slli_epi64(s1, 17)};
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = rotl_avx2<45>(s3);
+
+        _mm256_store_si256(p0, s0);
+        _mm256_store_si256(p1, s1);
+        _mm256_store_si256(p2, s2);
+        _mm256_store_si256(p3, s3);
+    }
+#endif
+};
+
+using Xoshiro256StarStarX4 = Xoshiro256StarStarLanes<4>;
+using Xoshiro256StarStarX8 = Xoshiro256StarStarLanes<8>;
+
+} // namespace Random
+
+#endif // !RANDOM_ENGINES_H
@@ -1,22 +1,40 @@
 #ifndef RANDOM_MT_H
 #define RANDOM_MT_H
 
+#include "random_engines.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
 #include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
 #include <limits>
+#include <optional>
 #include <random>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
 #include <type_traits>
+#include <utility>
 
 // This header-only Random namespace implements a self-seeding Mersenne Twister.
-// Requires C++17 or newer.
+// (The faster engines in random_engines.h can be swapped in, see Random::Engine below.)
+// Requires C++20 or newer (the bulk fill functions take a std::span).
 // It can be #included into as many code files as needed (The inline keyword avoids ODR violations)
 // Freely redistributable, courtesy of learncpp.com
 // (https://www.learncpp.com/cpp-tutorial/global-random-numbers-random-h/)
 namespace Random {
-// Returns a seeded Mersenne Twister
-// Note: we'd prefer to return a std::seed_seq (to initialize a std::mt19937), but std::seed can't
-// be copied, so it can't be returned by value. Instead, we'll create a std::mt19937, seed it, and
-// then return the std::mt19937 (which can be copied).
-inline std::mt19937 generate() {
+namespace detail {
+// Seeds an engine from std::random_device and the clock, so it differs on every run
+template <typename Engine> Engine generate_from_device() {
     std::random_device rd{};
 
     // Create seed_seq with clock and 7 random numbers from std::random_device
@@ -30,17 +48,410 @@ inline std::mt19937 generate() {
                      rd(),
                      rd()};
 
-    return std::mt19937{ss};
+    return Engine{ss};
+}
+
+// Cheap entropy for when std::random_device is too slow (it can be a syscall or a file read).
+// The clocks differ between runs, and ASLR moves the stack, the code and the thread id around, so
+// mixing them together is good enough for test data and simulations. It is NOT a secure seed.
+inline std::uint64_t fast_entropy() noexcept {
+    int on_the_stack{};
+    std::uint64_t state{static_cast<std::uint64_t>(
+        std::chrono::high_resolution_clock::now().time_since_epoch().count())};
+
+    std::uint64_t mixed{splitmix64(state)};
+    state ^=
+        static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    mixed ^= splitmix64(state);
+    state ^= static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&on_the_stack));
+    mixed ^= splitmix64(state);
+    state ^= static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&fast_entropy));
+    mixed ^= splitmix64(state);
+    state ^= std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return mixed ^ splitmix64(state);
+}
+
+// Reads a seed from the environment variable `name`: decimal, or hex with a 0x prefix
+inline std::optional<std::uint64_t> seed_from_environment(const char* name) {
+    const char* text{std::getenv(name)};
+    if (text == nullptr || *text == '\0') {
+        return std::nullopt;
+    }
+    char* end{nullptr};
+    errno = 0;
+    std::uint64_t value{std::strtoull(text, &end, 0)};
+    if (errno != 0 || *end != '\0') {
+        throw std::invalid_argument("Random: the seed in the environment is not a number.");
+    }
+    return value;
+}
+
+// The process-wide seed every engine is derived from.
+// By default it is drawn once from std::random_device (or fast_entropy() with -DRANDOM_FAST_SEED).
+// The RANDOM_SEED environment variable, or Random::seed(value) below, fixes it instead, which
+// makes a run repeatable. Setting RANDOM_SEED_LOG (to anything) logs every seed to stderr.
+struct SeedState {
+    std::atomic<std::uint64_t> root{};
+    std::atomic<bool> fixed{}; // false while the root is the one drawn from entropy
+    std::atomic<bool> log{};
+};
+
+// `first_root` is only looked at by the call that builds the state: Random::seed(value) passes
+// its value there, so that a program that fixes the seed never reads the entropy source.
+inline SeedState& seed_state(std::optional<std::uint64_t> first_root = std::nullopt) {
+    static SeedState state{[first_root]() -> SeedState {
+        bool log{std::getenv("RANDOM_SEED_LOG") != nullptr};
+        if (first_root) {
+            return SeedState{*first_root, true, log};
+        }
+        if (auto seed{seed_from_environment("RANDOM_SEED")}) {
+            return SeedState{*seed, true, log};
+        }
+#ifdef RANDOM_FAST_SEED
+        return SeedState{fast_entropy(), false, log};
+#else
+        std::mt19937 root{generate_from_device<std::mt19937>()};
+        return SeedState{(static_cast<std::uint64_t>(root()) << 32) | root(), false, log};
+#endif
+    }()};
+    return state;
+}
+
+inline std::uint64_t root_seed() { return seed_state().root.load(std::memory_order_relaxed); }
+
+// The root seed's splitmix64 sequence is cut into streams, one per engine, in three ranges that
+// never meet, so that asking for one kind of engine never shifts the streams of another:
+// * 0, 1, 2, ...: the threads' engines, in the order the threads first draw
+// * generated_streams + 0, 1, 2, ...: generate() and generate_fast(), in call order
+// * keyed_streams + key: a thread engine reseeded with Random::seed_thread(key)
+inline std::atomic<std::uint64_t> next_stream{0};
+inline std::atomic<std::uint64_t> next_generated{0};
+inline constexpr std::uint64_t generated_streams{std::uint64_t{1} << 58};
+inline constexpr std::uint64_t keyed_streams{std::uint64_t{1} << 59};
+
+// Each line also says whether the root seed was fixed or drawn from entropy for this run
+inline void log_seed(const char* what, std::uint64_t stream, std::uint64_t state) {
+    auto& seeds{seed_state()};
+    if (seeds.log.load(std::memory_order_relaxed)) {
+        std::fprintf(stderr,
+                     "Random: %s, stream %llu, seed 0x%016llx (RANDOM_SEED=0x%016llx, %s)\n",
+                     what, static_cast<unsigned long long>(stream),
+                     static_cast<unsigned long long>(state),
+                     static_cast<unsigned long long>(root_seed()),
+                     seeds.fixed.load(std::memory_order_relaxed) ? "fixed" : "from entropy");
+    }
+}
+
+// Seeds an Engine from its own slice of the root splitmix64 sequence.
+// Stream n uses outputs [8n, 8n + 8), so no two engines ever share seed material.
+inline constexpr std::uint64_t words_per_stream{8};
+
+inline std::uint64_t stream_state(std::uint64_t stream) {
+    return root_seed() + stream * words_per_stream * 0x9E3779B97F4A7C15ULL;
+}
+
+// A seed sequence that writes splitmix64 outputs straight into the engine's state words.
+// std::seed_seq first mixes its input over the whole output in several passes, which for a
+// std::mt19937 (624 words) is most of the cost of seeding; splitmix64 output is already well
+// mixed, so the fast paths skip that.
+class SplitMixSeeds {
+  public:
+    using result_type = std::uint32_t;
+
+    explicit SplitMixSeeds(std::uint64_t state) noexcept : m_state{state} {}
+
+    template <typename Iterator> void generate(Iterator first, Iterator last) {
+        while (first != last) {
+            std::uint64_t value{splitmix64(m_state)};
+            *first++ = static_cast<result_type>(value);
+            if (first != last) {
+                *first++ = static_cast<result_type>(value >> 32);
+            }
+        }
+    }
+
+  private:
+    std::uint64_t m_state{};
+};
+
+template <typename Engine> Engine seed_stream(const char* what, std::uint64_t stream) {
+    std::uint64_t state{stream_state(stream)};
+    log_seed(what, stream, state);
+
+    std::seed_seq::result_type words[2 * words_per_stream]{};
+    for (std::uint64_t i{}; i < words_per_stream; ++i) {
+        std::uint64_t value{splitmix64(state)};
+        words[2 * i] = static_cast<std::seed_seq::result_type>(value);
+        words[2 * i + 1] = static_cast<std::seed_seq::result_type>(value >> 32);
+    }
+    std::seed_seq ss(std::begin(words), std::end(words));
+    return Engine{ss};
+}
+} // namespace detail
+
+// Returns a seeded Mersenne Twister
+// Note: we'd prefer to return a std::seed_seq (to initialize a std::mt19937), but std::seed can't
+// be copied, so it can't be returned by value. Instead, we'll create a std::mt19937, seed it, and
+// then return the std::mt19937 (which can be copied).
+// Any other engine that takes a seed_seq can be asked for instead:
+// Sample call: Random::generate<Random::Xoshiro256StarStar>();
+// The engine comes from the next generate() stream of the process-wide seed (see Random::seed),
+// so it is different on every run unless that seed is fixed, and then the same on every run.
+template <typename Engine = std::mt19937> Engine generate() {
+    std::uint64_t stream{detail::next_generated.fetch_add(1, std::memory_order_relaxed)};
+    return detail::seed_stream<Engine>("generate()", detail::generated_streams + stream);
+}
+
+// Same as generate(), from the same streams, but the state words are filled from splitmix64
+// directly instead of through a std::seed_seq (see detail::SplitMixSeeds). Several times cheaper
+// for a std::mt19937. Only meant for non-cryptographic use.
+// Sample call: Random::generate_fast<Random::Xoshiro256StarStar>();
+template <typename Engine = std::mt19937> Engine generate_fast() {
+    std::uint64_t stream{
+        detail::generated_streams + detail::next_generated.fetch_add(1, std::memory_order_relaxed)};
+    std::uint64_t state{detail::stream_state(stream)};
+    detail::log_seed("generate_fast()", stream, state);
+    detail::SplitMixSeeds seeds{state};
+    return Engine{seeds};
+}
+
+// The engine behind Random::engine(), Random::get and Random::random, picked at build time.
+// std::mt19937 stays the default; the others are several times faster and far smaller:
+//     -DRANDOM_ENGINE_XOSHIRO256   Random::Xoshiro256StarStar
+//     -DRANDOM_ENGINE_PCG64        Random::Pcg64
+#if defined(RANDOM_ENGINE_XOSHIRO256)
+using Engine = Xoshiro256StarStar;
+#elif defined(RANDOM_ENGINE_PCG64)
+using Engine = Pcg64;
+#else
+using Engine = std::mt19937;
+#endif
+
+namespace detail {
+// Seeds a thread's engine from stream `stream` of the root seed
+inline Engine generate_stream(std::uint64_t stream) {
+#ifdef RANDOM_FAST_SEED
+    // Skip the seed_seq: for std::mt19937 it mixes all 624 words of state, which costs more than
+    // the rest of the engine setup combined
+    std::uint64_t state{stream_state(stream)};
+    log_seed("thread engine", stream, state);
+    SplitMixSeeds seeds{state};
+    return Engine{seeds};
+#else
+    return seed_stream<Engine>("thread engine", stream);
+#endif
+}
+
+// The key this thread passed to Random::seed_thread, if any
+inline thread_local std::optional<std::uint64_t> thread_key{};
+
+// Seeds a thread's engine from its keyed stream, or else the next thread stream
+inline Engine generate_stream() {
+    if (thread_key) {
+        return generate_stream(keyed_streams + *thread_key);
+    }
+    return generate_stream(next_stream.fetch_add(1, std::memory_order_relaxed));
+}
+} // namespace detail
+
+// Returns the calling thread's engine (a std::mt19937 unless another Engine was picked above).
+// The engine is a thread_local: every thread gets its own, seeded from its own stream, so
+// concurrent calls to Random::get never touch shared state and need no lock.
+// It lives inside this function rather than at namespace scope so that it is only built the
+// first time a thread asks for it. Programs that never draw a number never pay for seeding, and
+// nothing random happens during static initialization.
+// Each access to a thread_local costs a TLS lookup, so hot loops should fetch it once:
+//     auto& rng{Random::engine()};
+//     std::uniform_int_distribution die{1, 6};
+//     for (...) { roll = die(rng); }
+inline Engine& engine() {
+    thread_local Engine mt{detail::generate_stream()};
+    return mt;
+}
+
+// Seed capture and replay
+// Every engine above is derived from one process-wide seed. To make a run repeatable, fix it:
+// * from the environment: RANDOM_SEED=0x1234 ./benchmark
+// * from code, before the threads that draw numbers are started: Random::seed(0x1234);
+// Run with RANDOM_SEED_LOG=1 (or call Random::log_seeds(true)) to print each engine's seed to
+// stderr. Feeding the logged RANDOM_SEED back in replays the run:
+// * generate() / generate_fast() engines come back in call order
+// * thread engines are numbered in the order the threads first draw: the main thread's, when it
+//   draws before starting any others, comes back, and so does that of a thread started after
+//   the previous one drew. Threads that start drawing at the same time race for the numbers.
+//   A thread that calls Random::seed_thread(key) with a key of its own (e.g. its index in a
+//   pool) gets the same engine on every run regardless.
+
+// The process-wide seed in use
+inline std::uint64_t seed() { return detail::root_seed(); }
+
+// Fixes the process-wide seed and restarts the stream numbering. The calling thread's engine is
+// reseeded right away. Engines that other threads already have are NOT touched.
+inline void seed(std::uint64_t value) {
+    auto& state{detail::seed_state(value)};
+    state.root.store(value, std::memory_order_relaxed);
+    state.fixed.store(true, std::memory_order_relaxed);
+    detail::log_seed("seed()", 0, value);
+
+    // Make sure this thread's engine exists first, so that building it doesn't use up a stream
+    auto& rng{engine()};
+    detail::next_stream.store(0, std::memory_order_relaxed);
+    detail::next_generated.store(0, std::memory_order_relaxed);
+    rng = detail::generate_stream();
+}
+
+// Reseeds the calling thread's engine from the stream named `key` instead of the next one in
+// line, so that it does not depend on which thread drew first. Give each thread its own key.
+// Sample call (at the top of worker thread `index`): Random::seed_thread(index);
+inline void seed_thread(std::uint64_t key) {
+    // Set the key first: if this thread has no engine yet, building it must not take a stream
+    detail::thread_key = key;
+    engine() = detail::generate_stream();
+}
+
+// Turns the seed log on stderr on or off (it starts on if RANDOM_SEED_LOG is set)
+inline void log_seeds(bool on) { detail::seed_state().log.store(on, std::memory_order_relaxed); }
+
+namespace detail {
+// The helpers below assume an engine that produces full 32- or 64-bit words,
+// e.g. std::mt19937 or std::mt19937_64.
+template <typename Engine> constexpr bool is_32_bit_engine() {
+    return Engine::min() == 0 && Engine::max() == 0xFFFFFFFFULL;
+}
+
+template <typename Engine> constexpr bool is_64_bit_engine() {
+    return Engine::min() == 0 && Engine::max() == 0xFFFFFFFFFFFFFFFFULL;
+}
+
+template <typename Engine> constexpr std::uint32_t next_u32(Engine& rng) {
+    static_assert(is_32_bit_engine<Engine>() || is_64_bit_engine<Engine>(),
+                  "Random needs an engine that produces full 32- or 64-bit words");
+    if constexpr (is_32_bit_engine<Engine>()) {
+        return static_cast<std::uint32_t>(rng());
+    } else {
+        // the high half is the strongest part of most 64-bit generators
+        return static_cast<std::uint32_t>(rng() >> 32);
+    }
 }
 
-// Here's our global std::mt19937 object.
-// The inline keyword means we only have one global instance for our whole program.
-inline std::mt19937 mt{
-    generate()}; // generates a seeded std::mt19937 and copies it into our global object
+template <typename Engine> constexpr std::uint64_t next_u64(Engine& rng) {
+    if constexpr (is_64_bit_engine<Engine>()) {
+        return rng();
+    } else {
+        std::uint64_t high{next_u32(rng)};
+        return (high << 32) | next_u32(rng);
+    }
+}
+
+// Raw bits for an unsigned type, using as few engine calls as possible
+template <typename U, typename Engine> constexpr U next_bits(Engine& rng) {
+    if constexpr (sizeof(U) <= sizeof(std::uint32_t)) {
+        return static_cast<U>(next_u32(rng));
+    } else {
+        return static_cast<U>(next_u64(rng));
+    }
+}
+
+// Fills out with raw 64-bit words. Engines with their own bulk fill() (like the multi-lane
+// xoshiro) get to write whole blocks at once.
+template <typename Engine> void fill_bits(Engine& rng, std::span<std::uint64_t> out) {
+    if constexpr (requires { rng.fill(out); }) {
+        rng.fill(out);
+    } else {
+        for (auto& word : out) {
+            word = next_u64(rng);
+        }
+    }
+}
+
+} // namespace detail
+
+// Turns random bits into a float or double in [0, 1) without any division.
+// The top 52 bits (23 for float) are dropped into the mantissa of a number in [1, 2) and 1 is
+// subtracted. Only integer shifts/ors and one subtraction, so a loop of these vectorizes.
+// Every result is a multiple of 2^-52 (2^-23 for float).
+template <typename T> constexpr T to_unit(std::uint64_t bits) noexcept {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>,
+                  "Random::to_unit only supports float and double");
+    if constexpr (std::is_same_v<T, float>) {
+        // uses the high 32 bits of the draw
+        auto word{static_cast<std::uint32_t>(bits >> 32)};
+        return std::bit_cast<float>(0x3F800000U | (word >> 9)) - 1.0f;
+    } else {
+        return std::bit_cast<double>(0x3FF0000000000000ULL | (bits >> 12)) - 1.0;
+    }
+}
+
+// Returns a uniform value in [0, range). range must be greater than 0.
+// This is Lemire's multiply-shift reduction: the high half of (random bits * range) is the
+// result, and only draws that land in the small biased part of the low half are retried.
+// The common path has no division at all, unlike std::uniform_int_distribution.
+// Sample call: Random::bounded(rng, deck.size()); // index into deck
+template <typename Engine> constexpr std::uint64_t bounded(Engine& rng, std::uint64_t range) {
+    if (range <= 0xFFFFFFFFULL) {
+        auto range_32{static_cast<std::uint32_t>(range)};
+        std::uint64_t product{std::uint64_t{detail::next_u32(rng)} * range_32};
+        auto low{static_cast<std::uint32_t>(product)};
+        if (low < range_32) {
+            // (2^32 - range) % range: the number of low values that would bias the result
+            std::uint32_t threshold{static_cast<std::uint32_t>(0U - range_32) % range_32};
+            while (low < threshold) {
+                product = std::uint64_t{detail::next_u32(rng)} * range_32;
+                low = static_cast<std::uint32_t>(product);
+            }
+        }
+        return product >> 32;
+    }
+#ifdef __SIZEOF_INT128__
+    detail::uint128 product{detail::uint128{detail::next_u64(rng)} * range};
+    auto low{static_cast<std::uint64_t>(product)};
+    if (low < range) {
+        std::uint64_t threshold{(0ULL - range) % range};
+        while (low < threshold) {
+            product = detail::uint128{detail::next_u64(rng)} * range;
+            low = static_cast<std::uint64_t>(product);
+        }
+    }
+    return static_cast<std::uint64_t>(product >> 64);
+#else
+    return std::uniform_int_distribution<std::uint64_t>{0, range - 1}(rng);
+#endif
+}
+
+namespace detail {
+// bounded() for 32 random bits that were already drawn, e.g. in bulk with fill_bits(). In the
+// rare case that `bits` falls in the biased part, a fresh value is drawn from rng instead, so the
+// result is exactly uniform either way.
+template <typename Engine>
+constexpr std::uint32_t bounded_from_bits(Engine& rng, std::uint32_t bits, std::uint32_t range) {
+    std::uint64_t product{std::uint64_t{bits} * range};
+    auto low{static_cast<std::uint32_t>(product)};
+    if (low < range && low < static_cast<std::uint32_t>(0U - range) % range) {
+        return static_cast<std::uint32_t>(bounded(rng, range));
+    }
+    return static_cast<std::uint32_t>(product >> 32);
+}
+} // namespace detail
+
+namespace detail {
+// Uniform integer in [min, max] (inclusive) for any integral type
+template <typename T, typename Engine> constexpr T uniform_in(Engine& rng, T min, T max) {
+    static_assert(std::is_integral_v<T>, "Random::get only supports integral types");
+    using U = std::make_unsigned_t<T>;
+
+    auto width{static_cast<U>(static_cast<U>(max) - static_cast<U>(min))};
+    if (width == std::numeric_limits<U>::max()) {
+        // the whole range of T, any bit pattern will do
+        return static_cast<T>(next_bits<U>(rng));
+    }
+    auto offset{static_cast<U>(bounded(rng, std::uint64_t{width} + 1))};
+    return static_cast<T>(static_cast<U>(static_cast<U>(min) + offset));
+}
+} // namespace detail
 
 // Generate a random int between [min, max] (inclusive)
 // * also handles cases where the two arguments have different types but can be converted to int
-inline int get(int min, int max) { return std::uniform_int_distribution{min, max}(mt); }
+inline int get(int min, int max) { return detail::uniform_in(engine(), min, max); }
 
 // The following function templates can be used to generate random numbers in other cases
 
@@ -55,7 +466,7 @@ inline int get(int min, int max) { return std::uniform_int_distribution{min, max
 // *    unsigned short, unsigned int, unsigned long, or unsigned long long
 // Sample call: Random::get(1L, 6L);             // returns long
 // Sample call: Random::get(1u, 6u);             // returns unsigned int
-template <typename T> T get(T min, T max) { return std::uniform_int_distribution<T>{min, max}(mt); }
+template <typename T> T get(T min, T max) { return detail::uniform_in(engine(), min, max); }
 
 // Generate a random value between [min, max] (inclusive)
 // * min and max can have different types
@@ -68,17 +479,191 @@ template <typename R, typename S, typename T> R get(S min, T max) {
     return get<R>(static_cast<R>(min), static_cast<R>(max));
 }
 
-template <typename T> T random() {
+// Generate a random value between [min, max] (inclusive) from the given engine
+// * works with any engine: Random::engine(), Random::Pcg64, std::mt19937_64, ...
+// Sample call: Random::get(rng, 1, 6);
+template <std::uniform_random_bit_generator Engine, typename T>
+constexpr T get(Engine& rng, T min, T max) {
+    return detail::uniform_in(rng, min, max);
+}
+
+// Generate a random value spread over the whole range of T from the given engine
+// * integral T: every value of T
+// * floating point T: [0, 1)
+// Sample call: Random::random<double>(rng);
+template <typename T, std::uniform_random_bit_generator Engine> constexpr T random(Engine& rng) {
     if constexpr (std::is_integral_v<T>) {
-        return std::uniform_int_distribution<T>{std::numeric_limits<T>::min(),
-                                                std::numeric_limits<T>::max()}(mt);
+        // every bit pattern of T is equally likely, so raw engine bits are enough
+        return static_cast<T>(detail::next_bits<std::make_unsigned_t<T>>(rng));
+    } else if constexpr (std::is_same_v<T, float>) {
+        // 32 bits are plenty for a float: one std::mt19937 call instead of two
+        return to_unit<float>(std::uint64_t{detail::next_u32(rng)} << 32);
+    } else if constexpr (std::is_same_v<T, double>) {
+        return to_unit<double>(detail::next_u64(rng));
     } else {
 
         static_assert(std::is_floating_point_v<T>, "random_any only supports arithmetic types");
 
         // Best possible interpretation of “any float”
-        return std::generate_canonical<T, std::numeric_limits<T>::digits>(mt);
+        return std::generate_canonical<T, std::numeric_limits<T>::digits>(rng);
+    }
+}
+
+// Same as above, using the calling thread's engine
+template <typename T> T random() { return random<T>(engine()); }
+
+// Bulk generation
+// These fill a whole buffer in one call. The engine is looked up once and the range is worked out
+// once, so they are much cheaper than calling Random::get in a loop.
+
+// Fill out with values spread over the whole range of T (like Random::random<T>)
+// * floating point T: [0, 1), drawn a block at a time and converted with to_unit
+template <std::uniform_random_bit_generator Engine, typename T>
+void fill_uniform(Engine& rng, std::span<T> out) {
+    if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+        // Raw bits go into a small buffer that stays in L1, then one tight loop converts them.
+        // A float only needs half a word, so each word makes two floats.
+        constexpr std::size_t per_word{std::is_same_v<T, float> ? 2 : 1};
+        constexpr std::size_t block_words{256};
+        std::uint64_t bits[block_words];
+
+        for (std::size_t done{}; done < out.size();) {
+            std::size_t count{std::min(out.size() - done, block_words * per_word)};
+            std::size_t words{(count + per_word - 1) / per_word};
+            detail::fill_bits(rng, std::span{bits, words});
+
+            T* destination{out.data() + done};
+            if constexpr (per_word == 2) {
+                for (std::size_t i{}; i + 1 < count; i += 2) {
+                    destination[i] = to_unit<float>(bits[i / 2]);
+                    destination[i + 1] = to_unit<float>(bits[i / 2] << 32);
+                }
+                if (count % 2 != 0) {
+                    destination[count - 1] = to_unit<float>(bits[count / 2]);
+                }
+            } else {
+                for (std::size_t i{}; i < count; ++i) {
+                    destination[i] = to_unit<double>(bits[i]);
+                }
+            }
+            done += count;
+        }
+    } else if constexpr (std::is_integral_v<T>) {
+        for (auto& value : out) {
+            value = static_cast<T>(detail::next_bits<std::make_unsigned_t<T>>(rng));
+        }
+    } else {
+        static_assert(std::is_floating_point_v<T>,
+                      "Random::fill_uniform only supports arithmetic types");
+        for (auto& value : out) {
+            value = std::generate_canonical<T, std::numeric_limits<T>::digits>(rng);
+        }
+    }
+}
+
+// Fill out with values in [min, max] (inclusive)
+// * floating point T: [min, max), scaled from fill_uniform
+// Sample call: Random::fill(rng, std::span{values}, 0, 99);
+template <std::uniform_random_bit_generator Engine, typename T>
+void fill(Engine& rng, std::span<T> out, std::type_identity_t<T> min,
+          std::type_identity_t<T> max) {
+    if constexpr (std::is_floating_point_v<T>) {
+        fill_uniform(rng, out);
+        const T width{max - min};
+        for (auto& value : out) {
+            value = min + value * width;
+        }
+        return;
+    } else {
+        static_assert(std::is_integral_v<T>, "Random::fill only supports arithmetic types");
+        using U = std::make_unsigned_t<T>;
+
+        auto width{static_cast<U>(static_cast<U>(max) - static_cast<U>(min))};
+        if (width == std::numeric_limits<U>::max()) {
+            fill_uniform(rng, out);
+            return;
+        }
+
+        std::uint64_t range{std::uint64_t{width} + 1};
+        auto base{static_cast<U>(min)};
+        for (auto& value : out) {
+            value = static_cast<T>(static_cast<U>(base + static_cast<U>(bounded(rng, range))));
+        }
+    }
+}
+
+// Same as above, using the calling thread's engine
+// Sample call: Random::fill(std::span{values}, 0, 99);
+template <typename T>
+void fill(std::span<T> out, std::type_identity_t<T> min, std::type_identity_t<T> max) {
+    fill(engine(), out, min, max);
+}
+
+// Same as above, using the calling thread's engine
+template <typename T> void fill_uniform(std::span<T> out) { fill_uniform(engine(), out); }
+
+// Shuffling and compile-time tables
+// shuffle, get(rng, ...) and random<T>(rng) are constexpr, and so are the engines in
+// random_engines.h (std::mt19937 isn't before C++26). With a fixed seed the compiler can build a
+// table once and bake it into the binary: no work at startup and the same contents on every run.
+//     constexpr auto order{Random::make_permutation<256>(0x0DE7)};
+//     constexpr auto salts{Random::make_array<std::uint64_t, 8>(0x5A175)};
+//     constexpr auto fixture{Random::make_array<int, 20>(42, 0, 20)};
+
+// Shuffle a random access range in place (Fisher-Yates), every order equally likely
+// Sample call: Random::shuffle(rng, deck);
+template <std::uniform_random_bit_generator Engine, std::ranges::random_access_range Range>
+constexpr void shuffle(Engine& rng, Range&& range) {
+    auto first{std::ranges::begin(range)};
+    auto size{static_cast<std::uint64_t>(std::ranges::distance(range))};
+    for (std::uint64_t i{size}; i > 1; --i) {
+        auto pick{static_cast<std::ptrdiff_t>(bounded(rng, i))};
+        std::ranges::iter_swap(first + static_cast<std::ptrdiff_t>(i - 1), first + pick);
+    }
+}
+
+// Same as above, using the calling thread's engine (so never at compile time)
+template <std::ranges::random_access_range Range> void shuffle(Range&& range) {
+    shuffle(engine(), std::forward<Range>(range));
+}
+
+// 0 .. Size - 1 in an order fixed by seed
+template <std::size_t Size, typename T = std::size_t>
+constexpr std::array<T, Size> make_permutation(std::uint64_t seed) {
+    std::array<T, Size> table{};
+    for (std::size_t i{}; i < Size; ++i) {
+        table[i] = static_cast<T>(i);
+    }
+    Xoshiro256StarStar rng{seed};
+    shuffle(rng, table);
+    return table;
+}
+
+// Size values spread over the whole range of T ([0, 1) for floating point), fixed by seed
+template <typename T, std::size_t Size>
+constexpr std::array<T, Size> make_array(std::uint64_t seed) {
+    std::array<T, Size> table{};
+    Xoshiro256StarStar rng{seed};
+    for (auto& value : table) {
+        value = random<T>(rng);
+    }
+    return table;
+}
+
+// Size values in [min, max] (inclusive, or [min, max) for floating point), fixed by seed
+template <typename T, std::size_t Size>
+constexpr std::array<T, Size> make_array(std::uint64_t seed, std::type_identity_t<T> min,
+                                         std::type_identity_t<T> max) {
+    std::array<T, Size> table{};
+    Xoshiro256StarStar rng{seed};
+    for (auto& value : table) {
+        if constexpr (std::is_floating_point_v<T>) {
+            value = min + random<T>(rng) * (max - min);
+        } else {
+            value = get(rng, min, max);
+        }
     }
+    return table;
 }
 
 } // namespace Random
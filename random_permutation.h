@@ -0,0 +1,173 @@
+#ifndef RANDOM_PERMUTATION_H
+#define RANDOM_PERMUTATION_H
+
+#include "random_mt.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+
+namespace Random {
+// A pseudo-random ordering of [0, size) that is computed, not stored.
+// at(i) is where position i of the shuffled order points, in O(1) time and no memory, so even a
+// 2^40 key space can be walked in random order without a 2^40 element shuffle.
+//
+// Under the hood it is a keyed Feistel network, which is a bijection on 2^bits values for any
+// round function. bits is the smallest even width that covers size (so at most 4 * size values).
+// Results that land outside [0, size) are fed through the network again ("cycle walking") until
+// they fall inside, which stays a bijection on [0, size) and takes under 4 rounds on average.
+//
+// The whole order is also a range, and slices of it can be handed to different threads:
+//     Random::RandomPermutation order{std::uint64_t{1} << 40};
+//     for (std::uint64_t key : order.chunk(thread_index, thread_count)) { visit(key); }
+class RandomPermutation {
+  public:
+    class iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::uint64_t;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(const RandomPermutation* permutation, std::uint64_t position)
+            : m_permutation{permutation}, m_position{position} {}
+
+        value_type operator*() const { return m_permutation->at(m_position); }
+
+        iterator& operator++() {
+            ++m_position;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator temp{*this};
+            ++(*this);
+            return temp;
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs) {
+            return lhs.m_position == rhs.m_position;
+        }
+
+      private:
+        const RandomPermutation* m_permutation{nullptr};
+        std::uint64_t m_position{};
+    };
+
+    // Permutation of [0, size) with keys drawn from the calling thread's engine
+    explicit RandomPermutation(std::uint64_t size) : RandomPermutation(size, engine()) {}
+
+    // Permutation of [0, size) with keys drawn from rng
+    template <std::uniform_random_bit_generator Engine>
+    RandomPermutation(std::uint64_t size, Engine& rng) : m_size{size} {
+        if (size == 0) {
+            throw std::invalid_argument("RandomPermutation: size must be at least 1.");
+        }
+        auto bits{static_cast<int>(std::bit_width(size - 1))};
+        m_half_bits = bits <= 2 ? 1 : (bits + 1) / 2;
+        m_half_mask = (std::uint64_t{1} << m_half_bits) - 1;
+        for (auto& key : m_keys) {
+            key = detail::next_u64(rng);
+        }
+    }
+
+    std::uint64_t size() const noexcept { return m_size; }
+
+    // The index at position `position` of the shuffled order
+    std::uint64_t at(std::uint64_t position) const {
+        check(position);
+        std::uint64_t value{encrypt(position)};
+        while (value >= m_size) {
+            value = encrypt(value);
+        }
+        return value;
+    }
+
+    std::uint64_t operator[](std::uint64_t position) const { return at(position); }
+
+    // The position of `index` in the shuffled order, so inverse(at(i)) == i
+    std::uint64_t inverse(std::uint64_t index) const {
+        check(index);
+        std::uint64_t value{decrypt(index)};
+        while (value >= m_size) {
+            value = decrypt(value);
+        }
+        return value;
+    }
+
+    iterator begin() const { return iterator{this, 0}; }
+
+    iterator end() const { return iterator{this, m_size}; }
+
+    // Positions [first, last) of the shuffled order
+    // (returns a std::ranges::subrange<iterator>)
+    auto slice(std::uint64_t first, std::uint64_t last) const {
+        if (first > last || last > m_size) {
+            throw std::out_of_range("RandomPermutation: slice is out of range.");
+        }
+        return std::ranges::subrange{iterator{this, first}, iterator{this, last}};
+    }
+
+    // Part `part` of the order split into `parts` nearly equal, contiguous pieces
+    auto chunk(std::uint64_t part, std::uint64_t parts) const {
+        if (parts == 0 || part >= parts) {
+            throw std::out_of_range("RandomPermutation: chunk is out of range.");
+        }
+        auto boundary{[&](std::uint64_t piece) {
+            return m_size / parts * piece + std::min(piece, m_size % parts);
+        }};
+        return slice(boundary(part), boundary(part + 1));
+    }
+
+  private:
+    static constexpr int rounds{6};
+
+    std::uint64_t m_size{};
+    int m_half_bits{};
+    std::uint64_t m_half_mask{};
+    std::array<std::uint64_t, rounds> m_keys{};
+
+    void check(std::uint64_t value) const {
+        if (value >= m_size) {
+            throw std::out_of_range("RandomPermutation: index out of range.");
+        }
+    }
+
+    // Round function: the splitmix64 finalizer over the half block and the round key
+    std::uint64_t round_function(int round, std::uint64_t half) const noexcept {
+        std::uint64_t z{half + m_keys[static_cast<std::size_t>(round)]};
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return (z ^ (z >> 31)) & m_half_mask;
+    }
+
+    std::uint64_t encrypt(std::uint64_t value) const noexcept {
+        std::uint64_t left{value >> m_half_bits};
+        std::uint64_t right{value & m_half_mask};
+        for (int round{}; round < rounds; ++round) {
+            std::uint64_t next{left ^ round_function(round, right)};
+            left = right;
+            right = next;
+        }
+        return (left << m_half_bits) | right;
+    }
+
+    std::uint64_t decrypt(std::uint64_t value) const noexcept {
+        std::uint64_t left{value >> m_half_bits};
+        std::uint64_t right{value & m_half_mask};
+        for (int round{rounds - 1}; round >= 0; --round) {
+            std::uint64_t previous{right ^ round_function(round, left)};
+            right = left;
+            left = previous;
+        }
+        return (left << m_half_bits) | right;
+    }
+};
+} // namespace Random
+
+#endif // !RANDOM_PERMUTATION_H
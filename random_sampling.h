@@ -0,0 +1,197 @@
+#ifndef RANDOM_SAMPLING_H
+#define RANDOM_SAMPLING_H
+
+#include "random_mt.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace Random {
+namespace detail {
+// Robert Floyd's algorithm: exactly k draws and a hash set of the k picks.
+// For the j-th pick it draws from [0, n - k + j]; if that value is taken already, the top value
+// (n - k + j) can't be, so it is taken instead. Every k-subset comes out equally likely.
+template <typename Engine>
+std::vector<std::uint64_t> sample_floyd(Engine& rng, std::uint64_t n, std::size_t k) {
+    std::vector<std::uint64_t> picks{};
+    picks.reserve(k);
+    std::unordered_set<std::uint64_t> taken{};
+    taken.reserve(2 * k);
+
+    for (std::uint64_t top{n - k}; top < n; ++top) {
+        std::uint64_t pick{bounded(rng, top + 1)};
+        if (!taken.insert(pick).second) {
+            pick = top;
+            taken.insert(pick);
+        }
+        picks.push_back(pick);
+    }
+    return picks;
+}
+
+// Rejection sampling against a bitmap of n bits. Only used while n / 64 <= k, so the bitmap is
+// no bigger than the output, and k <= n / 2, so fewer than 2k draws are expected.
+template <typename Engine>
+std::vector<std::uint64_t> sample_bitmap(Engine& rng, std::uint64_t n, std::size_t k) {
+    std::vector<std::uint64_t> picks{};
+    picks.reserve(k);
+    std::vector<std::uint64_t> taken(static_cast<std::size_t>(n / 64 + 1));
+
+    while (picks.size() < k) {
+        std::uint64_t pick{bounded(rng, n)};
+        std::uint64_t& word{taken[static_cast<std::size_t>(pick / 64)]};
+        std::uint64_t bit{std::uint64_t{1} << (pick % 64)};
+        if ((word & bit) == 0) {
+            word |= bit;
+            picks.push_back(pick);
+        }
+    }
+    return picks;
+}
+
+// k draws with replacement, then any repeats are found by sorting and drawn again until all k
+// are distinct. Only used while k * k <= n, where fewer than one repeat is expected, so this is
+// about k draws and one sort of k values, with no hash set. Nothing here treats one index
+// differently from another, so every k-subset is equally likely. The picks are shuffled at the
+// end, so a prefix of the result is a random sample too rather than the smallest picks.
+template <typename Engine>
+std::vector<std::uint64_t> sample_sort_and_redraw(Engine& rng, std::uint64_t n, std::size_t k) {
+    std::vector<std::uint64_t> picks(k);
+    for (auto& pick : picks) {
+        pick = bounded(rng, n);
+    }
+    while (true) {
+        std::sort(picks.begin(), picks.end());
+        auto distinct{static_cast<std::size_t>(std::unique(picks.begin(), picks.end()) -
+                                               picks.begin())};
+        if (distinct == k) {
+            break;
+        }
+        for (std::size_t i{distinct}; i < k; ++i) {
+            picks[i] = bounded(rng, n);
+        }
+    }
+    shuffle(rng, picks);
+    return picks;
+}
+
+// The first k steps of a Fisher-Yates shuffle of 0..n-1. Only used while n <= 2k.
+template <typename Engine>
+std::vector<std::uint64_t> sample_partial_shuffle(Engine& rng, std::uint64_t n, std::size_t k) {
+    std::vector<std::uint64_t> indices(static_cast<std::size_t>(n));
+    std::iota(indices.begin(), indices.end(), std::uint64_t{0});
+
+    for (std::size_t i{}; i < k; ++i) {
+        std::size_t pick{i + static_cast<std::size_t>(bounded(rng, n - i))};
+        std::swap(indices[i], indices[pick]);
+    }
+    indices.resize(k);
+    return indices;
+}
+} // namespace detail
+
+// Returns k distinct indices picked uniformly from [0, n), without building the range.
+// Time and memory grow with k, not n: picking 10 indices out of 10^9 is 10 draws.
+// The method depends on how much of the range is wanted:
+// * k > n / 2:            partial Fisher-Yates shuffle (the range is at most 2k long)
+// * n / 64 <= k <= n / 2: rejection against a bitmap of n bits (at most k words)
+// * k * k <= n:           k draws, with the rare repeats found by sorting and drawn again
+// * otherwise:            Floyd's algorithm with a hash set
+// The indices come back in no particular order. Throws std::invalid_argument if k > n.
+// Sample call: Random::sample_indices(1'000'000'000, 5);
+template <std::uniform_random_bit_generator Engine>
+std::vector<std::uint64_t> sample_indices(Engine& rng, std::uint64_t n, std::size_t k) {
+    if (k > n) {
+        throw std::invalid_argument("sample_indices: can't pick more indices than there are.");
+    }
+    if (k == 0) {
+        return {};
+    }
+
+    if (k > n / 2) {
+        return detail::sample_partial_shuffle(rng, n, k);
+    }
+    if (n / 64 <= k) {
+        return detail::sample_bitmap(rng, n, k);
+    }
+    if (k <= n / k) {
+        return detail::sample_sort_and_redraw(rng, n, k);
+    }
+    return detail::sample_floyd(rng, n, k);
+}
+
+// Same as above, using the calling thread's engine
+inline std::vector<std::uint64_t> sample_indices(std::uint64_t n, std::size_t k) {
+    return sample_indices(engine(), n, k);
+}
+
+// [0, size) in random order, one index at a time: an incremental Fisher-Yates shuffle.
+// Step i swaps a random entry of [i, size) into place i, exactly like the full shuffle, so every
+// order is equally likely; stopping after k steps costs k draws.
+// Entries that were never touched still hold their own index, so while few have moved they are
+// kept in a hash map and nothing of size `size` is built. Past size / 16 moves the map is turned
+// into a plain array, which is faster for the rest of the walk.
+class LazyShuffle {
+  public:
+    LazyShuffle() = default;
+
+    explicit LazyShuffle(std::uint64_t size) : m_size{size} {}
+
+    std::uint64_t size() const noexcept { return m_size; }
+
+    // How many indices have been handed out
+    std::uint64_t position() const noexcept { return m_position; }
+
+    bool done() const noexcept { return m_position == m_size; }
+
+    // The next index of the order. Must not be called once done().
+    template <std::uniform_random_bit_generator Engine> std::uint64_t next(Engine& rng) {
+        std::uint64_t pick{m_position + bounded(rng, m_size - m_position)};
+        std::uint64_t value{get(pick)};
+        // place m_position is never read again, so only the pick's side of the swap is stored
+        set(pick, get(m_position));
+        ++m_position;
+        return value;
+    }
+
+  private:
+    std::uint64_t m_size{};
+    std::uint64_t m_position{};
+    std::unordered_map<std::uint64_t, std::uint64_t> m_moved{};
+    std::vector<std::uint64_t> m_order{}; // used instead of m_moved once it is filled
+
+    std::uint64_t get(std::uint64_t index) const {
+        if (!m_order.empty()) {
+            return m_order[static_cast<std::size_t>(index)];
+        }
+        auto found{m_moved.find(index)};
+        return found == m_moved.end() ? index : found->second;
+    }
+
+    void set(std::uint64_t index, std::uint64_t value) {
+        if (!m_order.empty()) {
+            m_order[static_cast<std::size_t>(index)] = value;
+            return;
+        }
+        m_moved[index] = value;
+        if (m_moved.size() > m_size / 16) {
+            m_order.resize(static_cast<std::size_t>(m_size));
+            std::iota(m_order.begin(), m_order.end(), std::uint64_t{0});
+            for (auto [moved_index, moved_value] : m_moved) {
+                m_order[static_cast<std::size_t>(moved_index)] = moved_value;
+            }
+            m_moved = {};
+        }
+    }
+};
+} // namespace Random
+
+#endif // !RANDOM_SAMPLING_H
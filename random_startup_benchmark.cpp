@@ -0,0 +1,76 @@
+/*
+  File: random_startup_benchmark.cpp
+
+  Shows what random_mt.h costs a program at startup, and what the first draw on a thread costs.
+
+  Build (default seeding, then the fast seeding mode):
+    g++ -std=c++20 -O2 -Wall -Wextra random_startup_benchmark.cpp -o startup_bench -pthread
+    g++ -std=c++20 -O2 -Wall -Wextra -DRANDOM_FAST_SEED random_startup_benchmark.cpp \
+        -o startup_bench_fast -pthread
+
+  Run:
+    ./startup_bench
+
+  What it measures:
+  - How many engines were seeded before main() started. Engines are created lazily, so this
+    must be 0: including the header costs nothing until something is drawn.
+  - generate() (through a std::seed_seq) against generate_fast() (splitmix64 straight into the
+    engine state), both seeded from streams of the process-wide seed.
+  - A thread that never draws against a thread whose first draw seeds its engine.
+*/
+
+#include "random_mt.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+// Runs before main() with the other static initializers of this file.
+// Random::detail::next_stream counts the engines handed out so far.
+static const std::uint64_t engines_before_main{Random::detail::next_stream.load()};
+
+template <typename Function> double average_ns(int repeats, Function&& function) {
+    auto start{std::chrono::steady_clock::now()};
+    for (int i{}; i < repeats; ++i) {
+        function();
+    }
+    std::chrono::duration<double, std::nano> elapsed{std::chrono::steady_clock::now() - start};
+    return elapsed.count() / repeats;
+}
+
+int main() {
+    constexpr int repeats{2000};
+    std::uint64_t sink{};
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "engines seeded before main():     " << engines_before_main << "\n";
+    std::cout << "engines seeded at start of main(): " << Random::detail::next_stream.load()
+              << "\n\n";
+
+    std::cout << "generate<std::mt19937>()          "
+              << average_ns(repeats, [&] { sink += Random::generate()(); }) << " ns\n";
+    std::cout << "generate_fast<std::mt19937>()     "
+              << average_ns(repeats, [&] { sink += Random::generate_fast()(); }) << " ns\n";
+    std::cout << "generate<Xoshiro256StarStar>()    " << average_ns(repeats, [&] {
+        sink += Random::generate<Random::Xoshiro256StarStar>()();
+    }) << " ns\n";
+    std::cout << "generate_fast<Xoshiro256StarStar> " << average_ns(repeats, [&] {
+        sink += Random::generate_fast<Random::Xoshiro256StarStar>()();
+    }) << " ns\n\n";
+
+    // Every new thread starts without an engine, so its first draw pays the whole seeding cost
+    double idle_thread{average_ns(repeats, [] { std::thread{[] {}}.join(); })};
+    double drawing_thread{
+        average_ns(repeats, [] { std::thread{[] { Random::get(1, 6); }}.join(); })};
+
+    std::cout << "thread that never draws           " << idle_thread << " ns\n";
+    std::cout << "thread whose first draw seeds     " << drawing_thread << " ns\n";
+    std::cout << "  => lazy engine setup per thread " << drawing_thread - idle_thread << " ns\n";
+
+    // keeps the optimizer from dropping the engines above
+    return sink == 42 ? 1 : 0;
+}
@@ -2,44 +2,215 @@
 #define RANDOMIZED_QUEUE_H
 
 #include "random_mt.h"
+#include "random_sampling.h"
 
+#include <algorithm>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <span>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
+// A queue that can hand out a random element.
+// The elements live in one contiguous ring buffer whose capacity is a power of two, so:
+// * enqueue is amortized O(1) with no allocation per element
+// * sample() is O(1): one random index into the buffer
+// * dequeue_random() is O(1): the picked element trades places with the last one, which is popped
+// * dequeue() is O(1) too, and in Mode::fifo it takes the oldest element (the front of the ring)
+// dequeue_random() moves the last element into the hole it leaves, so once it has been used the
+// remaining elements are no longer in arrival order.
+// The buffer is raw storage: only the slots in use hold an element, so T needs no default
+// constructor, only a copy or move constructor.
+//
+// Iterating visits every element once, in a fresh random order each time begin() is called:
+//     for (const auto& item : queue) { ... }
+// Every iterator has its own engine and its own LazyShuffle of the indices, so several of them can
+// walk the same queue at once (from different threads too, as long as nobody modifies it), and
+// one that stops early has only paid for the elements it reached. Copies of an iterator share
+// its position, like any input iterator. Modifying the queue invalidates its iterators.
 template <typename T> class RandomizedQueue {
-  private:
-    struct Node {
-        T value{};
-        Node* next{nullptr};
-
-        Node() = default;
+  public:
+    enum class Mode {
+        fifo,   // dequeue() takes the oldest element
+        random, // dequeue() is dequeue_random()
+    };
 
-        explicit Node(const T& other_value, Node* other_next)
-            : value{other_value}, next{other_next} {}
+    enum class Draw {
+        without_replacement, // every element at most once
+        with_replacement,    // each pick is independent, elements can repeat
     };
 
-    Node* m_tail{};
-    Node* m_head{};
+  private:
+    T* m_items{nullptr};      // the ring buffer, with room for m_capacity elements
+    std::size_t m_capacity{}; // 0 or a power of two
+    std::size_t m_head{};     // slot of the oldest element
     std::size_t m_size{};
+    Mode m_mode{Mode::fifo};
+
+    static constexpr std::size_t initial_capacity{16};
+
+    // slot of the element `index` places after the head
+    std::size_t slot(std::size_t index) const noexcept {
+        return (m_head + index) & (m_capacity - 1);
+    }
+
+    // Destroys the elements and frees the buffer
+    void release() noexcept {
+        for (std::size_t index{}; index < m_size; ++index) {
+            std::destroy_at(m_items + slot(index));
+        }
+        if (m_items != nullptr) {
+            std::allocator<T>{}.deallocate(m_items, m_capacity);
+        }
+    }
+
+    // Moves the elements, oldest first, into a new buffer with room for `capacity` of them.
+    // If a move throws, the queue is left as it was.
+    void relocate(std::size_t capacity) {
+        T* items{std::allocator<T>{}.allocate(capacity)};
+        std::size_t moved{};
+        try {
+            for (; moved < m_size; ++moved) {
+                std::construct_at(items + moved, std::move_if_noexcept(m_items[slot(moved)]));
+            }
+        } catch (...) {
+            std::destroy_n(items, moved);
+            std::allocator<T>{}.deallocate(items, capacity);
+            throw;
+        }
+        release();
+        m_items = items;
+        m_capacity = capacity;
+        m_head = 0;
+    }
+
+    void grow() {
+        relocate(m_capacity == 0 ? initial_capacity : 2 * m_capacity);
+    }
+
+    // Removes the element in `picked` by moving the last element into it
+    void fill_hole(T& picked) {
+        T& last{m_items[slot(m_size - 1)]};
+        if (&picked != &last) {
+            picked = std::move(last);
+        }
+        std::destroy_at(&last);
+        --m_size;
+    }
+
+    void check_not_empty() const {
+        if (empty()) {
+            throw std::logic_error("The container is empty!.");
+        }
+    }
 
   public:
+    class iterator {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        iterator() = default;
+
+        reference operator*() const {
+            return m_order->queue->m_items[m_order->queue->slot(m_order->current)];
+        }
+
+        pointer operator->() const {
+            return &**this;
+        }
+
+        iterator& operator++() {
+            m_order->advance();
+            return *this;
+        }
+
+        void operator++(int) {
+            ++(*this);
+        }
+
+        // Any two finished iterators are equal, so a default constructed one is the end
+        friend bool operator==(const iterator& lhs, const iterator& rhs) {
+            if (lhs.at_end() || rhs.at_end()) {
+                return lhs.at_end() == rhs.at_end();
+            }
+            return lhs.m_order == rhs.m_order;
+        }
+
+      private:
+        friend class RandomizedQueue;
+
+        struct Order {
+            const RandomizedQueue* queue{nullptr};
+            Random::Xoshiro256StarStar rng{};
+            Random::LazyShuffle shuffle{};
+            std::size_t current{};
+            bool finished{};
+
+            void advance() {
+                finished = shuffle.done();
+                if (!finished) {
+                    current = static_cast<std::size_t>(shuffle.next(rng));
+                }
+            }
+        };
+
+        std::shared_ptr<Order> m_order{};
+
+        bool at_end() const noexcept {
+            return !m_order || m_order->finished;
+        }
+
+        explicit iterator(const RandomizedQueue* queue) : m_order{std::make_shared<Order>()} {
+            m_order->queue = queue;
+            m_order->rng.seed(Random::detail::next_u64(Random::engine()));
+            m_order->shuffle = Random::LazyShuffle{queue->m_size};
+            m_order->advance();
+        }
+    };
+
     RandomizedQueue() = default;
 
-    ~RandomizedQueue() {
-        while (m_head) {
-            Node* temp = m_head;
-            m_head = m_head->next;
-            delete temp;
+    explicit RandomizedQueue(Mode mode) : m_mode{mode} {}
+
+    // Delegates to RandomizedQueue(Mode) so that the destructor cleans up if a copy throws
+    RandomizedQueue(const RandomizedQueue& other) : RandomizedQueue(other.m_mode) {
+        reserve(other.m_size);
+        for (std::size_t index{}; index < other.m_size; ++index) {
+            enqueue(other.m_items[other.slot(index)]);
         }
     }
 
-    // TODO: implement move semantics
-    RandomizedQueue(const RandomizedQueue&) = delete;
-    RandomizedQueue(RandomizedQueue&&) = delete;
-    RandomizedQueue& operator=(const RandomizedQueue&) = delete;
-    RandomizedQueue& operator=(RandomizedQueue&&) = delete;
+    RandomizedQueue(RandomizedQueue&& other) noexcept
+        : m_items{std::exchange(other.m_items, nullptr)},
+          m_capacity{std::exchange(other.m_capacity, 0)}, m_head{std::exchange(other.m_head, 0)},
+          m_size{std::exchange(other.m_size, 0)}, m_mode{other.m_mode} {}
+
+    // Copy and move assignment both: `other` is already the copy (or the moved-from queue)
+    RandomizedQueue& operator=(RandomizedQueue other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~RandomizedQueue() {
+        release();
+    }
+
+    void swap(RandomizedQueue& other) noexcept {
+        std::swap(m_items, other.m_items);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_head, other.m_head);
+        std::swap(m_size, other.m_size);
+        std::swap(m_mode, other.m_mode);
+    }
 
     bool empty() const noexcept {
         return m_size == 0;
@@ -49,52 +220,187 @@ template <typename T> class RandomizedQueue {
         return m_size;
     }
 
-    void enqueue(const T& item) {
+    std::size_t capacity() const noexcept {
+        return m_capacity;
+    }
 
-        Node* new_node = new Node(item, nullptr);
+    Mode mode() const noexcept {
+        return m_mode;
+    }
 
-        if (empty()) {
-            m_tail = m_head = new_node;
-            ++m_size;
-        } else {
-            m_tail->next = new_node;
-            m_tail = new_node;
-            ++m_size;
+    void set_mode(Mode mode) noexcept {
+        m_mode = mode;
+    }
+
+    // Makes room for `count` elements, so that many enqueues won't reallocate
+    void reserve(std::size_t count) {
+        if (count > m_capacity) {
+            relocate(std::max(initial_capacity, std::bit_ceil(count)));
         }
     }
 
-    auto dequeue() -> T {
-        if (empty()) {
-            throw std::logic_error("The container is empty!.");
+    void enqueue(const T& item) {
+        if (m_size == m_capacity) {
+            grow();
         }
+        std::construct_at(m_items + slot(m_size), item);
+        ++m_size;
+    }
 
-        auto* temp = m_head;
-        auto value = temp->value;
+    void enqueue(T&& item) {
+        if (m_size == m_capacity) {
+            grow();
+        }
+        std::construct_at(m_items + slot(m_size), std::move(item));
+        ++m_size;
+    }
 
-        m_head = m_head->next;
-        if (!m_head) {
-            // when there is only one node in the list
-            // first is also pointing to the some node
-            m_tail = m_head = nullptr;
+    // Removes the oldest element (Mode::fifo) or a random one (Mode::random)
+    auto dequeue() -> T {
+        if (m_mode == Mode::random) {
+            return dequeue_random();
         }
+        check_not_empty();
+
+        T value{std::move(m_items[m_head])};
+        std::destroy_at(m_items + m_head);
+        m_head = slot(1);
         --m_size;
-        delete temp;
         return value;
     }
 
+    // Removes a uniformly random element
+    template <std::uniform_random_bit_generator Engine> auto dequeue_random(Engine& rng) -> T {
+        check_not_empty();
+
+        T& picked{m_items[slot(Random::bounded(rng, m_size))]};
+        T value{std::move(picked)};
+        fill_hole(picked);
+        return value;
+    }
+
+    auto dequeue_random() -> T {
+        return dequeue_random(Random::engine());
+    }
+
+    // Returns a copy of a uniformly random element without removing it
+    template <std::uniform_random_bit_generator Engine> auto sample(Engine& rng) const -> T {
+        check_not_empty();
+        return m_items[slot(Random::bounded(rng, m_size))];
+    }
+
     auto sample() const -> T {
-        if (empty()) {
-            throw std::logic_error("The container is empty!.");
+        return sample(Random::engine());
+    }
+
+    // Batch versions of sample() and dequeue(). The checks and the engine lookup happen once per
+    // batch, and the indices are drawn in one go, so a batch of k costs far less than k calls.
+
+    // Writes copies of `count` random elements to out and returns the end of what was written.
+    // Without replacement, count must not be more than size(); the picks come out in no
+    // particular order. Throws std::logic_error if count > 0 and the queue is empty.
+    // Sample call: queue.sample(rng, 64, std::back_inserter(batch));
+    template <std::uniform_random_bit_generator Engine, std::output_iterator<const T&> Output>
+    Output sample(Engine& rng, std::size_t count, Output out,
+                  Draw draw = Draw::without_replacement) const {
+        if (count == 0) {
+            return out;
         }
+        check_not_empty();
 
-        Node* current = m_head;
-        auto random_num = Random::get<std::size_t>(0, m_size - 1);
+        if (draw == Draw::without_replacement) {
+            if (count > m_size) {
+                throw std::invalid_argument("Can't sample more elements than there are!.");
+            }
+            for (std::uint64_t index : Random::sample_indices(rng, m_size, count)) {
+                *out++ = m_items[slot(static_cast<std::size_t>(index))];
+            }
+            return out;
+        }
 
-        for (std::size_t index = 0; index < random_num; ++index) {
-            current = current->next;
+        constexpr std::size_t block_size{256};
+        std::uint64_t indices[block_size];
+        for (std::size_t done{}; done < count;) {
+            std::size_t block{std::min(count - done, block_size)};
+            Random::fill(rng, std::span{indices, block}, 0, m_size - 1);
+            for (std::size_t i{}; i < block; ++i) {
+                *out++ = m_items[slot(static_cast<std::size_t>(indices[i]))];
+            }
+            done += block;
         }
+        return out;
+    }
+
+    template <std::output_iterator<const T&> Output>
+    Output sample(std::size_t count, Output out, Draw draw = Draw::without_replacement) const {
+        return sample(Random::engine(), count, out, draw);
+    }
+
+    // Same as above, returned in a vector
+    std::vector<T> sample(std::size_t count, Draw draw = Draw::without_replacement) const {
+        std::vector<T> picks{};
+        picks.reserve(count);
+        sample(Random::engine(), count, std::back_inserter(picks), draw);
+        return picks;
+    }
+
+    // Removes up to `count` elements, moving them to out, and returns the end of what was written.
+    // Like dequeue(), it takes the oldest elements in Mode::fifo and random ones in Mode::random.
+    // A batch bigger than the queue just empties it.
+    // Sample call: queue.dequeue_n(rng, 256, std::back_inserter(work));
+    template <std::uniform_random_bit_generator Engine, std::output_iterator<T&&> Output>
+    Output dequeue_n(Engine& rng, std::size_t count, Output out) {
+        count = std::min(count, m_size);
+
+        if (m_mode == Mode::fifo) {
+            // The head moves on with every element, so a throwing out leaves the queue intact
+            for (std::size_t i{}; i < count; ++i) {
+                *out++ = std::move(m_items[m_head]);
+                std::destroy_at(m_items + m_head);
+                m_head = slot(1);
+                --m_size;
+            }
+            return out;
+        }
+
+        // The first `count` steps of a Fisher-Yates shuffle run from the back: each pick is
+        // swapped out for the last element. The random bits for a whole block of picks are
+        // drawn in one fill_bits() call, 32 per pick, and only reduced to [0, size) one by one,
+        // because the size shrinks with every pick.
+        constexpr std::size_t block_size{256};
+        std::uint64_t bits[block_size / 2];
+        for (std::size_t done{}; done < count;) {
+            std::size_t block{std::min(count - done, block_size)};
+            Random::detail::fill_bits(rng, std::span{bits, (block + 1) / 2});
+            for (std::size_t i{}; i < block; ++i) {
+                std::uint64_t index{};
+                if (m_size <= 0xFFFFFFFF) {
+                    auto word{static_cast<std::uint32_t>(bits[i / 2] >> (32 * (i % 2)))};
+                    index = Random::detail::bounded_from_bits(rng, word,
+                                                              static_cast<std::uint32_t>(m_size));
+                } else {
+                    index = Random::bounded(rng, m_size);
+                }
+                T& picked{m_items[slot(static_cast<std::size_t>(index))]};
+                *out++ = std::move(picked);
+                fill_hole(picked);
+            }
+            done += block;
+        }
+        return out;
+    }
+
+    template <std::output_iterator<T&&> Output> Output dequeue_n(std::size_t count, Output out) {
+        return dequeue_n(Random::engine(), count, out);
+    }
+
+    // A new walk over every element in random order
+    iterator begin() const {
+        return iterator{this};
+    }
 
-        return current->value;
+    iterator end() const noexcept {
+        return iterator{};
     }
 };
 #endif // !RANDOMIZED_QUEUE_H
@@ -0,0 +1,274 @@
+/*
+  File: randomized_queue_benchmark.cpp
+
+  Compares the ring buffer RandomizedQueue (randomized_queue.h) with the linked list version it
+  replaced, which is kept below as LinkedRandomizedQueue.
+
+  Build:
+    g++ -std=c++20 -O2 -Wall -Wextra randomized_queue_benchmark.cpp -o queue_bench
+
+  Run:
+    ./queue_bench
+    RANDOM_SEED=1 ./queue_bench     # the same random picks on every run
+
+  For every size it reports ns per operation for:
+  - enqueue:        filling an empty queue with `size` elements
+  - sample:         sample() on the full queue (the linked list walks to the index, O(n))
+  - dequeue:        FIFO dequeue() until the queue is empty
+  - dequeue_random: dequeue_random() until the queue is empty (ring buffer only)
+  The linked list only gets a few hundred samples at the big sizes; more would take minutes.
+
+  A second table compares batch pulls (sample(k), dequeue_n) with k single calls, per element.
+  A third one does the same for WeightedRandomizedQueue (weighted_randomized_queue.h), whose
+  batch sample walks the sum tree once for a whole batch of draws.
+*/
+
+#include "randomized_queue.h"
+#include "weighted_randomized_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+// The linked list RandomizedQueue as it was before it moved to a ring buffer
+template <typename T> class LinkedRandomizedQueue {
+  private:
+    struct Node {
+        T value{};
+        Node* next{nullptr};
+
+        Node() = default;
+
+        explicit Node(const T& other_value, Node* other_next)
+            : value{other_value}, next{other_next} {}
+    };
+
+    Node* m_tail{};
+    Node* m_head{};
+    std::size_t m_size{};
+
+  public:
+    LinkedRandomizedQueue() = default;
+
+    ~LinkedRandomizedQueue() {
+        while (m_head) {
+            Node* temp = m_head;
+            m_head = m_head->next;
+            delete temp;
+        }
+    }
+
+    LinkedRandomizedQueue(const LinkedRandomizedQueue&) = delete;
+    LinkedRandomizedQueue& operator=(const LinkedRandomizedQueue&) = delete;
+
+    bool empty() const noexcept { return m_size == 0; }
+
+    void enqueue(const T& item) {
+        Node* new_node = new Node(item, nullptr);
+        if (empty()) {
+            m_tail = m_head = new_node;
+        } else {
+            m_tail->next = new_node;
+            m_tail = new_node;
+        }
+        ++m_size;
+    }
+
+    auto dequeue() -> T {
+        if (empty()) {
+            throw std::logic_error("The container is empty!.");
+        }
+        auto* temp = m_head;
+        auto value = temp->value;
+        m_head = m_head->next;
+        if (!m_head) {
+            m_tail = m_head = nullptr;
+        }
+        --m_size;
+        delete temp;
+        return value;
+    }
+
+    auto sample() const -> T {
+        if (empty()) {
+            throw std::logic_error("The container is empty!.");
+        }
+        Node* current = m_head;
+        auto random_num = Random::bounded(Random::engine(), m_size);
+        for (std::size_t index = 0; index < random_num; ++index) {
+            current = current->next;
+        }
+        return current->value;
+    }
+};
+
+template <typename Function> double ns_per_op(std::size_t operations, Function&& function) {
+    auto start{std::chrono::steady_clock::now()};
+    function();
+    std::chrono::duration<double, std::nano> elapsed{std::chrono::steady_clock::now() - start};
+    return elapsed.count() / static_cast<double>(operations);
+}
+
+std::uint64_t sink{};
+
+template <typename Queue> void benchmark(const char* name, std::size_t size, std::size_t samples) {
+    Queue queue{};
+    double enqueue{ns_per_op(size, [&] {
+        for (std::size_t i{}; i < size; ++i) {
+            queue.enqueue(static_cast<int>(i));
+        }
+    })};
+    double sample{ns_per_op(samples, [&] {
+        for (std::size_t i{}; i < samples; ++i) {
+            sink += static_cast<std::uint64_t>(queue.sample());
+        }
+    })};
+    double dequeue{ns_per_op(size, [&] {
+        while (!queue.empty()) {
+            sink += static_cast<std::uint64_t>(queue.dequeue());
+        }
+    })};
+
+    std::cout << std::setw(8) << name << std::setw(10) << size << std::setw(12) << enqueue
+              << std::setw(14) << sample << std::setw(12) << dequeue;
+
+    if constexpr (requires { queue.dequeue_random(); }) {
+        for (std::size_t i{}; i < size; ++i) {
+            queue.enqueue(static_cast<int>(i));
+        }
+        double dequeue_random{ns_per_op(size, [&] {
+            while (!queue.empty()) {
+                sink += static_cast<std::uint64_t>(queue.dequeue_random());
+            }
+        })};
+        std::cout << std::setw(18) << dequeue_random;
+    } else {
+        std::cout << std::setw(18) << "-";
+    }
+    std::cout << "\n";
+}
+
+void benchmark_batches(std::size_t batch) {
+    constexpr std::size_t size{1'000'000};
+    using Queue = RandomizedQueue<int>;
+    Queue queue{Queue::Mode::random};
+    for (std::size_t i{}; i < size; ++i) {
+        queue.enqueue(static_cast<int>(i));
+    }
+    std::vector<int> out{};
+    out.reserve(batch);
+    const std::size_t rounds{size / batch / 2};
+
+    double single_sample{ns_per_op(rounds * batch, [&] {
+        for (std::size_t round{}; round < rounds; ++round) {
+            out.clear();
+            for (std::size_t i{}; i < batch; ++i) {
+                out.push_back(queue.sample());
+            }
+        }
+    })};
+    double batch_sample{ns_per_op(rounds * batch, [&] {
+        for (std::size_t round{}; round < rounds; ++round) {
+            out.clear();
+            queue.sample(batch, std::back_inserter(out), Queue::Draw::with_replacement);
+        }
+    })};
+    double batch_distinct{ns_per_op(rounds * batch, [&] {
+        for (std::size_t round{}; round < rounds; ++round) {
+            out.clear();
+            queue.sample(batch, std::back_inserter(out));
+        }
+    })};
+    double single_dequeue{ns_per_op(rounds * batch, [&] {
+        for (std::size_t round{}; round < rounds; ++round) {
+            out.clear();
+            for (std::size_t i{}; i < batch; ++i) {
+                out.push_back(queue.dequeue());
+            }
+        }
+    })};
+    double batch_dequeue{ns_per_op(rounds * batch, [&] {
+        for (std::size_t round{}; round < rounds; ++round) {
+            out.clear();
+            queue.dequeue_n(batch, std::back_inserter(out));
+        }
+    })};
+    sink += static_cast<std::uint64_t>(out.back());
+
+    std::cout << std::setw(8) << batch << std::setw(12) << single_sample << std::setw(12)
+              << batch_sample << std::setw(16) << batch_distinct << std::setw(12)
+              << single_dequeue << std::setw(12) << batch_dequeue << "\n";
+}
+
+void benchmark_weighted(std::size_t size) {
+    constexpr std::size_t draws{std::size_t{1} << 20};
+    constexpr std::size_t batch{1024};
+    WeightedRandomizedQueue<int> queue{};
+    for (std::size_t i{}; i < size; ++i) {
+        queue.enqueue(static_cast<int>(i), 1.0 + Random::random<double>(Random::engine()));
+    }
+    auto& rng{Random::engine()};
+    std::vector<int> out{};
+    out.reserve(batch);
+
+    double single{ns_per_op(draws, [&] {
+        for (std::size_t i{}; i < draws; ++i) {
+            sink += static_cast<std::uint64_t>(queue.sample(rng));
+        }
+    })};
+    double batched{ns_per_op(draws, [&] {
+        for (std::size_t round{}; round < draws / batch; ++round) {
+            out.clear();
+            queue.sample(rng, batch, std::back_inserter(out));
+            sink += static_cast<std::uint64_t>(out.back());
+        }
+    })};
+    double update{ns_per_op(draws, [&] {
+        for (std::size_t i{}; i < draws; ++i) {
+            queue.set_weight(Random::bounded(rng, size), 1.0 + Random::random<double>(rng));
+        }
+    })};
+
+    std::cout << std::setw(10) << size << std::setw(12) << single << std::setw(16) << batched
+              << std::setw(14) << update << "\n";
+}
+
+int main() {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(8) << "queue" << std::setw(10) << "size" << std::setw(12) << "enqueue"
+              << std::setw(14) << "sample" << std::setw(12) << "dequeue" << std::setw(18)
+              << "dequeue_random"
+              << "\n";
+
+    for (std::size_t size : {1'000, 10'000, 100'000, 1'000'000}) {
+        // keep the linked list's O(n) samples to about 10^8 node steps per size
+        std::size_t linked_samples{std::clamp<std::size_t>(200'000'000 / size, 100, 100'000)};
+        benchmark<LinkedRandomizedQueue<int>>("linked", size, linked_samples);
+        benchmark<RandomizedQueue<int>>("ring", size, 1'000'000);
+    }
+    std::cout << "(ns per operation)\n\n";
+
+    std::cout << std::setw(8) << "batch" << std::setw(12) << "sample()" << std::setw(12)
+              << "sample(k)" << std::setw(16) << "sample(k) dist." << std::setw(12) << "dequeue()"
+              << std::setw(12) << "dequeue_n"
+              << "\n";
+    for (std::size_t batch : {64, 256, 1024}) {
+        benchmark_batches(batch);
+    }
+    std::cout << "(ns per element, queue of 10^6 in Mode::random)\n\n";
+
+    std::cout << std::setw(10) << "weighted" << std::setw(12) << "sample()" << std::setw(16)
+              << "sample(1024)" << std::setw(14) << "set_weight"
+              << "\n";
+    for (std::size_t size : {1'000, 100'000, 1'000'000, 8'000'000}) {
+        benchmark_weighted(size);
+    }
+    std::cout << "(ns per element)\n";
+    return 0;
+}
@@ -0,0 +1,157 @@
+#ifndef RESERVOIR_SAMPLER_H
+#define RESERVOIR_SAMPLER_H
+
+#include "random_mt.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Random {
+// Keeps a uniform random sample of up to `capacity` items from a stream of unknown length,
+// in O(capacity) memory.
+// This is Li's Algorithm L ("Reservoir-Sampling Algorithms of Time Complexity O(n(1 + log(N/n)))",
+// 1994): instead of a coin flip per item it draws how many items to skip before the next one is
+// kept, so the engine is only called O(k log(n / k)) times for n items.
+// skip_count() tells the reader how many upcoming items will be thrown away, so it can skip them
+// without even building them. For a big log file read line by line:
+//     Random::ReservoirSampler<std::string> sampler{100};
+//     std::string line{};
+//     while (in) {
+//         for (auto skip{sampler.skip_count()}; skip > 0 && in.peek() != EOF; --skip) {
+//             in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+//             sampler.skip(1);
+//         }
+//         if (std::getline(in, line)) {
+//             sampler.offer(std::move(line));
+//         }
+//     }
+// Samplers that ran over separate shards of the input can be combined with merge().
+template <typename T> class ReservoirSampler {
+  public:
+    explicit ReservoirSampler(std::size_t capacity) : m_capacity{capacity} {
+        if (capacity == 0) {
+            throw std::invalid_argument("ReservoirSampler: capacity must be at least 1.");
+        }
+        m_items.reserve(capacity);
+    }
+
+    std::size_t capacity() const noexcept { return m_capacity; }
+
+    std::size_t size() const noexcept { return m_items.size(); }
+
+    bool empty() const noexcept { return m_items.empty(); }
+
+    // How many items of the stream have gone past, kept or not
+    std::uint64_t seen() const noexcept { return m_seen; }
+
+    // The sample so far (in no particular order)
+    const std::vector<T>& items() const noexcept { return m_items; }
+
+    // How many of the next items will be rejected whatever they are
+    std::uint64_t skip_count() const noexcept {
+        return m_seen < m_capacity ? 0 : m_next - m_seen;
+    }
+
+    // Passes over `count` items without looking at them. count must not exceed skip_count().
+    void skip(std::uint64_t count) {
+        if (count > skip_count()) {
+            throw std::logic_error("ReservoirSampler: can't skip an item that might be kept.");
+        }
+        m_seen += count;
+    }
+
+    // Offers the next item of the stream. Returns true if it went into the sample.
+    bool offer(const T& item) { return place(item); }
+
+    bool offer(T&& item) { return place(std::move(item)); }
+
+    // Folds in a sampler that ran over a different part of the stream.
+    // Afterwards this holds a uniform sample of both parts together, as if it had seen them all.
+    // other needs at least this sampler's capacity.
+    void merge(const ReservoirSampler& other) {
+        if (other.m_capacity < m_capacity) {
+            throw std::invalid_argument("ReservoirSampler: can't merge a smaller reservoir.");
+        }
+
+        auto& rng{engine()};
+        std::vector<T> mine{std::move(m_items)};
+        std::vector<T> theirs{other.m_items};
+        std::uint64_t mine_left{m_seen};
+        std::uint64_t theirs_left{other.m_seen};
+
+        // Every pick comes from one side in proportion to how much of the stream it still covers,
+        // then a random item of that side's (already uniform) sample is taken out.
+        m_items.clear();
+        while (m_items.size() < m_capacity && mine_left + theirs_left > 0) {
+            bool from_mine{bounded(rng, mine_left + theirs_left) < mine_left};
+            auto& pool{from_mine ? mine : theirs};
+            (from_mine ? mine_left : theirs_left) -= 1;
+
+            std::size_t pick{static_cast<std::size_t>(bounded(rng, pool.size()))};
+            m_items.push_back(std::move(pool[pick]));
+            pool[pick] = std::move(pool.back());
+            pool.pop_back();
+        }
+
+        m_seen += other.m_seen;
+        if (m_seen >= m_capacity) {
+            // W is the largest key in the reservoir, distributed Beta(k, n - k + 1)
+            std::gamma_distribution<double> kept{static_cast<double>(m_capacity)};
+            std::gamma_distribution<double> rest{static_cast<double>(m_seen - m_capacity + 1)};
+            double x{kept(rng)};
+            m_threshold = x / (x + rest(rng));
+            m_next = m_seen + gap(rng);
+        }
+    }
+
+  private:
+    std::size_t m_capacity{};
+    std::vector<T> m_items{};
+    std::uint64_t m_seen{};
+    std::uint64_t m_next{}; // index in the stream of the next item to keep
+    double m_threshold{};   // Algorithm L's W
+
+    // Uniform in (0, 1), never exactly 0 so it is safe to take the log
+    template <typename Engine> static double open_unit(Engine& rng) {
+        return (static_cast<double>(detail::next_u64(rng) >> 11) + 0.5) * 0x1.0p-53;
+    }
+
+    // Geometric number of items to pass over before the next one is kept
+    template <typename Engine> std::uint64_t gap(Engine& rng) const {
+        double items{std::floor(std::log(open_unit(rng)) / std::log1p(-m_threshold))};
+        constexpr auto far{static_cast<double>(std::numeric_limits<std::uint64_t>::max() / 2)};
+        return items < far ? static_cast<std::uint64_t>(items) : static_cast<std::uint64_t>(far);
+    }
+
+    template <typename U> bool place(U&& item) {
+        std::uint64_t index{m_seen++};
+
+        if (index < m_capacity) {
+            m_items.push_back(std::forward<U>(item));
+            if (m_seen == m_capacity) {
+                auto& rng{engine()};
+                m_threshold = std::exp(std::log(open_unit(rng)) / static_cast<double>(m_capacity));
+                m_next = m_seen + gap(rng);
+            }
+            return true;
+        }
+        if (index < m_next) {
+            return false;
+        }
+
+        auto& rng{engine()};
+        m_items[static_cast<std::size_t>(bounded(rng, m_capacity))] = std::forward<U>(item);
+        m_threshold *= std::exp(std::log(open_unit(rng)) / static_cast<double>(m_capacity));
+        m_next = m_seen + gap(rng);
+        return true;
+    }
+};
+} // namespace Random
+
+#endif // !RESERVOIR_SAMPLER_H
@@ -0,0 +1,65 @@
+/*
+  File: sort_benchmark.cpp
+
+  Times Sorts::pdq_sort (elementary_sorts.h) against std::sort on every Workload shape, for int
+  and double.
+
+  Build:
+    g++ -std=c++20 -O2 -march=native -Wall -Wextra sort_benchmark.cpp -o sort_bench -pthread
+
+  Run:
+    ./sort_bench                  # 10^7 elements per shape
+    ./sort_bench 1000000          # fewer for a quick look
+    RANDOM_SEED=7 ./sort_bench    # the same inputs on every run
+
+  Both sorts get the same input, and the outputs are compared, so a wrong answer shows up as
+  "MISMATCH" instead of a fast time.
+*/
+
+#include "elementary_sorts.h"
+#include "workload_generator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+template <typename Work> double time_ms(Work work) {
+    auto start{std::chrono::steady_clock::now()};
+    work();
+    std::chrono::duration<double, std::milli> elapsed{std::chrono::steady_clock::now() - start};
+    return elapsed.count();
+}
+
+template <typename T> void benchmark(std::string_view type, int size) {
+    for (auto shape : Workload::all_shapes) {
+        Sorts<T> sorts{};
+        sorts.resize(size);
+        sorts.initialize(shape);
+        std::vector<T> expected(sorts.data().begin(), sorts.data().end());
+
+        double pdq_ms{time_ms([&] { sorts.pdq_sort(); })};
+        double std_ms{time_ms([&] { std::sort(expected.begin(), expected.end()); })};
+        bool same{std::equal(expected.begin(), expected.end(), sorts.data().begin())};
+
+        std::cout << std::setw(8) << type << std::setw(16) << Workload::name(shape)
+                  << std::setw(12) << pdq_ms << std::setw(12) << std_ms << std::setw(10)
+                  << std_ms / pdq_ms << (same ? "" : "  MISMATCH") << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int size{argc > 1 ? std::atoi(argv[1]) : 10'000'000};
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << size << " elements\n";
+    std::cout << std::setw(8) << "type" << std::setw(16) << "shape" << std::setw(12) << "pdq ms"
+              << std::setw(12) << "std ms" << std::setw(10) << "speedup" << "\n";
+    benchmark<int>("int", size);
+    benchmark<double>("double", size);
+    return 0;
+}
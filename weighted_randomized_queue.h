@@ -0,0 +1,325 @@
+#ifndef WEIGHTED_RANDOMIZED_QUEUE_H
+#define WEIGHTED_RANDOMIZED_QUEUE_H
+
+#include "random_mt.h"
+#include "ziggurat.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// A RandomizedQueue whose sample() and dequeue() pick each element with probability
+// weight / (sum of weights), e.g. to retry cheap jobs more often than expensive ones.
+// The weights sit in a Fenwick tree (a binary indexed tree of partial sums), so enqueue,
+// set_weight, sample, dequeue and remove are all O(log n). A draw walks down the tree from the
+// top, keeping the left or right half of the remaining weight at every level.
+// enqueue returns a Handle that names the element until it leaves the queue (after that the
+// handle can be given to a new element). Elements with weight 0 are kept but never picked.
+// Sample call:
+//     WeightedRandomizedQueue<Job> jobs{};
+//     auto handle{jobs.enqueue(job, 4.0)};
+//     jobs.set_weight(handle, 0.5);
+//     Job next{jobs.dequeue()};
+template <typename T> class WeightedRandomizedQueue {
+  public:
+    using Handle = std::size_t;
+
+  private:
+    // Element i of the queue (its "slot") is m_items[i]; the slots are always 0 .. size() - 1
+    std::vector<T> m_items{};
+    std::vector<double> m_weights{};
+    std::vector<Handle> m_handle_of_slot{};
+    std::vector<std::size_t> m_slot_of_handle{}; // no_slot for handles not in use
+    std::vector<Handle> m_free_handles{};
+
+    // m_tree[i] (1-based) is the sum of the weights of slots [i - lowbit(i), i). Its size is a
+    // power of two plus one, so m_tree[capacity] is the total and a draw can start at the top.
+    std::vector<double> m_tree{0.0};
+    std::size_t m_changes{};  // tree updates since the last rebuild
+    std::size_t m_positive{}; // elements with a weight above 0
+
+    static constexpr std::size_t no_slot{~std::size_t{0}};
+
+    std::size_t capacity() const noexcept {
+        return m_tree.size() - 1;
+    }
+
+    static void check_weight(double weight) {
+        if (!std::isfinite(weight) || weight < 0) {
+            throw std::invalid_argument(
+                "WeightedRandomizedQueue: weights must be finite and non-negative.");
+        }
+    }
+
+    std::size_t slot_of(Handle handle) const {
+        if (handle >= m_slot_of_handle.size() || m_slot_of_handle[handle] == no_slot) {
+            throw std::out_of_range("WeightedRandomizedQueue: no element has this handle.");
+        }
+        return m_slot_of_handle[handle];
+    }
+
+    // Rebuilds the tree from m_weights in O(capacity)
+    void rebuild(std::size_t new_capacity) {
+        m_tree.assign(new_capacity + 1, 0.0);
+        for (std::size_t slot{}; slot < m_weights.size(); ++slot) {
+            m_tree[slot + 1] = m_weights[slot];
+        }
+        for (std::size_t index{1}; index < new_capacity; ++index) {
+            std::size_t parent{index + (index & (0 - index))};
+            if (parent <= new_capacity) {
+                m_tree[parent] += m_tree[index];
+            }
+        }
+        m_changes = 0;
+    }
+
+    void add(std::size_t slot, double delta) {
+        for (std::size_t index{slot + 1}; index <= capacity(); index += index & (0 - index)) {
+            m_tree[index] += delta;
+        }
+        ++m_changes;
+    }
+
+    // Each update leaves a little rounding error in the sums. Rebuilding from the exact weights
+    // after every size() updates keeps that bounded, at O(1) amortized cost.
+    // Called once m_weights is consistent again.
+    void limit_rounding() {
+        if (m_changes > std::max<std::size_t>(m_weights.size(), 1024)) {
+            rebuild(capacity());
+        }
+    }
+
+    void check_can_sample() const {
+        if (m_positive == 0) {
+            throw std::logic_error("WeightedRandomizedQueue: there is nothing to sample!.");
+        }
+    }
+
+    // The slot whose share of the cumulative weight contains `target` (0 <= target < total),
+    // searching below `position` with steps of `step` and less
+    std::size_t find(double target, std::size_t position, std::size_t step) const {
+        for (; step > 0; step /= 2) {
+            // written so that it compiles to conditional moves: which way a random draw goes is
+            // a coin flip, and a mispredicted branch per level would cost more than the load
+            double left{m_tree[position + step]};
+            bool right{left <= target};
+            target -= right ? left : 0.0;
+            position += right ? step : 0;
+        }
+        return settle(position);
+    }
+
+    std::size_t find(double target) const {
+        return find(target, 0, capacity() / 2);
+    }
+
+    // Rounding can push a walk onto a slot past the end or one with weight 0; step back to the
+    // nearest slot that can be picked (there is one, check_can_sample made sure of that)
+    std::size_t settle(std::size_t slot) const {
+        slot = std::min(slot, m_weights.size() - 1);
+        while (m_weights[slot] == 0 && slot > 0) {
+            --slot;
+        }
+        while (m_weights[slot] == 0) {
+            ++slot;
+        }
+        return slot;
+    }
+
+    // Finds the slots for many sorted targets in one walk down the tree. Targets that go the
+    // same way at a node are split off together, so each tree node is loaded once per batch
+    // instead of once per draw, and the upper levels stay in cache.
+    void find_sorted(std::size_t position, std::size_t step, std::span<double> targets,
+                     std::span<std::size_t> slots) const {
+        if (targets.empty()) {
+            return;
+        }
+        if (targets.size() == 1) {
+            slots[0] = find(targets[0], position, step);
+            return;
+        }
+        if (step == 0) {
+            std::size_t slot{settle(position)};
+            std::fill(slots.begin(), slots.end(), slot);
+            return;
+        }
+        double left{m_tree[position + step]};
+        auto split{static_cast<std::size_t>(
+            std::partition_point(targets.begin(), targets.end(),
+                                 [left](double target) { return target < left; }) -
+            targets.begin())};
+        for (std::size_t i{split}; i < targets.size(); ++i) {
+            targets[i] -= left;
+        }
+        find_sorted(position, step / 2, targets.first(split), slots.first(split));
+        find_sorted(position + step, step / 2, targets.subspan(split), slots.subspan(split));
+    }
+
+    // Moves the last element into `slot` and drops the last slot
+    T remove_slot(std::size_t slot) {
+        std::size_t last{m_items.size() - 1};
+        T value{std::move(m_items[slot])};
+        m_slot_of_handle[m_handle_of_slot[slot]] = no_slot;
+        m_free_handles.push_back(m_handle_of_slot[slot]);
+
+        m_positive -= m_weights[slot] > 0;
+        if (slot != last) {
+            add(slot, m_weights[last] - m_weights[slot]);
+            m_items[slot] = std::move(m_items[last]);
+            m_weights[slot] = m_weights[last];
+            m_handle_of_slot[slot] = m_handle_of_slot[last];
+            m_slot_of_handle[m_handle_of_slot[slot]] = slot;
+        }
+        add(last, -m_weights[last]);
+        m_items.pop_back();
+        m_weights.pop_back();
+        m_handle_of_slot.pop_back();
+        limit_rounding();
+        return value;
+    }
+
+    template <typename Item> Handle push(Item&& item, double weight) {
+        check_weight(weight);
+        std::size_t slot{m_items.size()};
+        m_items.push_back(std::forward<Item>(item));
+        m_weights.push_back(weight);
+        m_positive += weight > 0;
+
+        Handle handle{m_slot_of_handle.size()};
+        if (!m_free_handles.empty()) {
+            handle = m_free_handles.back();
+            m_free_handles.pop_back();
+            m_slot_of_handle[handle] = slot;
+        } else {
+            m_slot_of_handle.push_back(slot);
+        }
+        m_handle_of_slot.push_back(handle);
+
+        if (slot >= capacity()) {
+            rebuild(std::bit_ceil(slot + 1));
+        } else {
+            add(slot, weight);
+            limit_rounding();
+        }
+        return handle;
+    }
+
+  public:
+    WeightedRandomizedQueue() = default;
+
+    bool empty() const noexcept {
+        return m_items.empty();
+    }
+
+    std::size_t size() const noexcept {
+        return m_items.size();
+    }
+
+    double total_weight() const noexcept {
+        return m_tree[capacity()];
+    }
+
+    Handle enqueue(const T& item, double weight) {
+        return push(item, weight);
+    }
+
+    Handle enqueue(T&& item, double weight) {
+        return push(std::move(item), weight);
+    }
+
+    bool contains(Handle handle) const noexcept {
+        return handle < m_slot_of_handle.size() && m_slot_of_handle[handle] != no_slot;
+    }
+
+    double weight(Handle handle) const {
+        return m_weights[slot_of(handle)];
+    }
+
+    void set_weight(Handle handle, double weight) {
+        check_weight(weight);
+        std::size_t slot{slot_of(handle)};
+        add(slot, weight - m_weights[slot]);
+        m_positive += static_cast<std::size_t>(weight > 0) - (m_weights[slot] > 0);
+        m_weights[slot] = weight;
+        limit_rounding();
+    }
+
+    const T& operator[](Handle handle) const {
+        return m_items[slot_of(handle)];
+    }
+
+    // Returns a copy of an element picked in proportion to its weight
+    template <std::uniform_random_bit_generator Engine> auto sample(Engine& rng) const -> T {
+        check_can_sample();
+        return m_items[find(Random::random<double>(rng) * total_weight())];
+    }
+
+    auto sample() const -> T {
+        return sample(Random::engine());
+    }
+
+    // Removes an element picked in proportion to its weight
+    template <std::uniform_random_bit_generator Engine> auto dequeue(Engine& rng) -> T {
+        check_can_sample();
+        return remove_slot(find(Random::random<double>(rng) * total_weight()));
+    }
+
+    auto dequeue() -> T {
+        return dequeue(Random::engine());
+    }
+
+    // Removes the element with this handle, whatever its weight
+    auto remove(Handle handle) -> T {
+        return remove_slot(slot_of(handle));
+    }
+
+    // Writes copies of `count` independent weighted picks to out (with replacement).
+    // The draws are made in sorted order and walked down the tree together (see find_sorted),
+    // then put back in random order, which saves most of the cache misses of `count` separate
+    // sample() calls on a big queue.
+    // Sample call: queue.sample(rng, 512, std::back_inserter(batch));
+    template <std::uniform_random_bit_generator Engine, std::output_iterator<const T&> Output>
+    Output sample(Engine& rng, std::size_t count, Output out) const {
+        if (count == 0) {
+            return out;
+        }
+        check_can_sample();
+
+        // `count` sorted uniform targets straight away, with no sort: the running sums of count + 1
+        // exponential gaps, scaled so that the last one lands on the total weight
+        std::vector<double> targets(count + 1);
+        Random::fill_exponential(rng, std::span{targets});
+        for (std::size_t i{1}; i <= count; ++i) {
+            targets[i] += targets[i - 1];
+        }
+        const double scale{total_weight() / targets[count]};
+        targets.pop_back();
+        for (auto& target : targets) {
+            target *= scale;
+        }
+        std::vector<std::size_t> slots(count);
+        find_sorted(0, capacity() / 2, std::span{targets}, std::span{slots});
+        Random::shuffle(rng, slots);
+
+        for (std::size_t slot : slots) {
+            *out++ = m_items[slot];
+        }
+        return out;
+    }
+
+    // Same as above, returned in a vector
+    std::vector<T> sample(std::size_t count) const {
+        std::vector<T> picks{};
+        picks.reserve(count);
+        sample(Random::engine(), count, std::back_inserter(picks));
+        return picks;
+    }
+};
+#endif // !WEIGHTED_RANDOMIZED_QUEUE_H
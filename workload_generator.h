@@ -0,0 +1,265 @@
+#ifndef WORKLOAD_GENERATOR_H
+#define WORKLOAD_GENERATOR_H
+
+#include "random_mt.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Input shapes for sort and container benchmarks.
+// Real data is rarely uniform, so a benchmark should sweep several shapes:
+//     std::vector<int> data(n);
+//     for (auto shape : Workload::all_shapes) {
+//         Workload::fill(std::span{data}, shape, seed);
+//         ... time the sort ...
+//     }
+// Generation is split over threads, but every chunk of the output draws from its own
+// Random::Philox4x32 stream, so the same seed gives the same data whatever the thread count.
+namespace Workload {
+enum class Shape {
+    uniform,        // independent values over the whole range of T ([0, 1) for floating point)
+    zipfian,        // value k with probability proportional to 1 / (k + 1)^s, hot values small
+    few_unique,     // only Options::unique_values distinct values, equally likely
+    sorted_runs,    // back to back sorted runs of Options::run_length random values
+    reverse_sorted, // n - 1 down to 0
+    organ_pipe,     // 0 up to the middle, then back down to 0
+    sawtooth,       // 0 .. run_length - 1, repeated
+    nearly_sorted,  // 0 .. n - 1 with Options::swap_percent of positions swapped at random
+};
+
+inline constexpr std::array all_shapes{Shape::uniform,        Shape::zipfian,    Shape::few_unique,
+                                       Shape::sorted_runs,    Shape::reverse_sorted,
+                                       Shape::organ_pipe,     Shape::sawtooth,
+                                       Shape::nearly_sorted};
+
+constexpr std::string_view name(Shape shape) {
+    switch (shape) {
+    case Shape::uniform:
+        return "uniform";
+    case Shape::zipfian:
+        return "zipfian";
+    case Shape::few_unique:
+        return "few_unique";
+    case Shape::sorted_runs:
+        return "sorted_runs";
+    case Shape::reverse_sorted:
+        return "reverse_sorted";
+    case Shape::organ_pipe:
+        return "organ_pipe";
+    case Shape::sawtooth:
+        return "sawtooth";
+    case Shape::nearly_sorted:
+        return "nearly_sorted";
+    }
+    return "unknown";
+}
+
+struct Options {
+    double zipf_exponent{1.0};    // s for Shape::zipfian
+    std::uint64_t zipf_values{0}; // number of distinct zipfian values, 0 means the output size
+    std::size_t unique_values{16};
+    std::size_t run_length{1024}; // for sorted_runs and sawtooth
+    double swap_percent{1.0};     // for nearly_sorted
+    unsigned threads{0};          // 0 means std::thread::hardware_concurrency()
+};
+
+namespace detail {
+// Every chunk of this many elements gets its own Philox stream
+inline constexpr std::size_t chunk_size{std::size_t{1} << 16};
+
+// Calls body(first, last) over [0, count) split into contiguous pieces, one per thread
+template <typename Body> void parallel_for(std::size_t count, unsigned threads, Body body) {
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    std::size_t workers{std::min<std::size_t>(threads, count)};
+    if (workers <= 1) {
+        body(std::size_t{0}, count);
+        return;
+    }
+
+    std::vector<std::thread> pool{};
+    pool.reserve(workers - 1);
+    for (std::size_t worker{1}; worker < workers; ++worker) {
+        pool.emplace_back(body, count * worker / workers, count * (worker + 1) / workers);
+    }
+    body(std::size_t{0}, count / workers);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+// Runs make(rng, index) for every index, with a Philox stream per chunk
+template <typename T, typename Make>
+void fill_chunks(std::span<T> out, std::uint64_t seed, unsigned threads, Make make) {
+    std::size_t chunks{(out.size() + chunk_size - 1) / chunk_size};
+    parallel_for(chunks, threads, [&](std::size_t first, std::size_t last) {
+        for (std::size_t chunk{first}; chunk < last; ++chunk) {
+            Random::Philox4x32 rng{seed, chunk};
+            std::size_t end{std::min(out.size(), (chunk + 1) * chunk_size)};
+            for (std::size_t i{chunk * chunk_size}; i < end; ++i) {
+                out[i] = make(rng, i);
+            }
+        }
+    });
+}
+
+// Zipf distribution over 1..count by rejection-inversion (Hormann and Derflinger,
+// "Rejection-inversion to generate variates from monotone discrete distributions", 1996).
+// O(1) per draw and no table, so count can be as large as the output.
+class ZipfSampler {
+  public:
+    ZipfSampler(std::uint64_t count, double exponent) : m_count{count}, m_exponent{exponent} {
+        if (count == 0 || !(exponent > 0)) {
+            throw std::invalid_argument("Workload: zipf needs values and a positive exponent.");
+        }
+        m_integral_first = integral(1.5) - 1.0;
+        m_integral_last = integral(static_cast<double>(count) + 0.5);
+        m_squeeze = 2.0 - integral_inverse(integral(2.5) - density(2.0));
+    }
+
+    template <typename Engine> std::uint64_t operator()(Engine& rng) const {
+        while (true) {
+            double u{m_integral_last + Random::to_unit<double>(Random::detail::next_u64(rng)) *
+                                           (m_integral_first - m_integral_last)};
+            double x{integral_inverse(u)};
+            double k{std::clamp(std::floor(x + 0.5), 1.0, static_cast<double>(m_count))};
+            if (k - x <= m_squeeze || u >= integral(k + 0.5) - density(k)) {
+                return static_cast<std::uint64_t>(k);
+            }
+        }
+    }
+
+  private:
+    std::uint64_t m_count{};
+    double m_exponent{};
+    double m_integral_first{};
+    double m_integral_last{};
+    double m_squeeze{};
+
+    // log1p(x) / x and expm1(x) / x, with the series near 0 where they lose precision
+    static double log1p_over(double x) {
+        if (std::abs(x) > 1e-8) {
+            return std::log1p(x) / x;
+        }
+        return 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+
+    static double expm1_over(double x) {
+        if (std::abs(x) > 1e-8) {
+            return std::expm1(x) / x;
+        }
+        return 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x));
+    }
+
+    double density(double x) const { return std::exp(-m_exponent * std::log(x)); }
+
+    double integral(double x) const {
+        double log_x{std::log(x)};
+        return expm1_over((1.0 - m_exponent) * log_x) * log_x;
+    }
+
+    double integral_inverse(double x) const {
+        double t{std::max(-1.0, x * (1.0 - m_exponent))};
+        return std::exp(log1p_over(t) * x);
+    }
+};
+} // namespace detail
+
+// Fills out with the given shape. The same seed, shape and options always give the same data.
+template <typename T>
+void fill(std::span<T> out, Shape shape, std::uint64_t seed, const Options& options = {}) {
+    static_assert(std::is_arithmetic_v<T>, "Workload only generates arithmetic types");
+    const std::size_t size{out.size()};
+    if (size == 0) {
+        return;
+    }
+    const std::size_t run_length{std::max<std::size_t>(1, options.run_length)};
+
+    switch (shape) {
+    case Shape::uniform:
+    case Shape::sorted_runs:
+        detail::fill_chunks(out, seed, options.threads,
+                            [](auto& rng, std::size_t) { return Random::random<T>(rng); });
+        if (shape == Shape::sorted_runs) {
+            std::size_t runs{(size + run_length - 1) / run_length};
+            detail::parallel_for(runs, options.threads, [&](std::size_t first, std::size_t last) {
+                for (std::size_t run{first}; run < last; ++run) {
+                    auto begin{out.begin() + static_cast<std::ptrdiff_t>(run * run_length)};
+                    auto end{out.begin() +
+                             static_cast<std::ptrdiff_t>(std::min(size, (run + 1) * run_length))};
+                    std::sort(begin, end);
+                }
+            });
+        }
+        break;
+
+    case Shape::zipfian: {
+        detail::ZipfSampler zipf{options.zipf_values == 0 ? size : options.zipf_values,
+                                 options.zipf_exponent};
+        detail::fill_chunks(out, seed, options.threads, [&](auto& rng, std::size_t) {
+            return static_cast<T>(zipf(rng) - 1);
+        });
+        break;
+    }
+
+    case Shape::few_unique: {
+        std::uint64_t unique{std::max<std::size_t>(1, options.unique_values)};
+        detail::fill_chunks(out, seed, options.threads, [&](auto& rng, std::size_t) {
+            return static_cast<T>(Random::bounded(rng, unique));
+        });
+        break;
+    }
+
+    case Shape::reverse_sorted:
+        detail::fill_chunks(out, seed, options.threads, [&](auto&, std::size_t i) {
+            return static_cast<T>(size - 1 - i);
+        });
+        break;
+
+    case Shape::organ_pipe:
+        detail::fill_chunks(out, seed, options.threads, [&](auto&, std::size_t i) {
+            return static_cast<T>(i < size / 2 ? i : size - 1 - i);
+        });
+        break;
+
+    case Shape::sawtooth:
+        detail::fill_chunks(out, seed, options.threads, [&](auto&, std::size_t i) {
+            return static_cast<T>(i % run_length);
+        });
+        break;
+
+    case Shape::nearly_sorted: {
+        detail::fill_chunks(out, seed, options.threads,
+                            [](auto&, std::size_t i) { return static_cast<T>(i); });
+        // The swaps are few and can touch any two positions, so they run on one stream.
+        // Its stream number sits past every chunk's.
+        Random::Philox4x32 rng{seed, ~std::uint64_t{0}};
+        // each swap moves two positions
+        double moved{static_cast<double>(size) * options.swap_percent / 100};
+        auto swaps{static_cast<std::size_t>(moved / 2)};
+        for (std::size_t swap{}; swap < swaps; ++swap) {
+            std::swap(out[Random::bounded(rng, size)], out[Random::bounded(rng, size)]);
+        }
+        break;
+    }
+    }
+}
+
+// Same as above, seeded from the calling thread's Random engine
+template <typename T> void fill(std::span<T> out, Shape shape, const Options& options = {}) {
+    fill(out, shape, Random::detail::next_u64(Random::engine()), options);
+}
+} // namespace Workload
+
+#endif // !WORKLOAD_GENERATOR_H
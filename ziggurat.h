@@ -0,0 +1,291 @@
+#ifndef ZIGGURAT_H
+#define ZIGGURAT_H
+
+#include "random_mt.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <type_traits>
+
+// Normal and exponential random numbers with the ziggurat method
+// (Marsaglia and Tsang, "The Ziggurat Method for Generating Random Variables", 2000, in the
+// floating point form of Doornik's ZIGNOR, 2005).
+// The density is covered by equal-area horizontal layers. A draw picks a layer and a point in it
+// from one 64-bit word; about 99% of the time the point is inside the curve and is returned after
+// one multiply and one compare. Only the thin wedges and the tail need exp/log.
+// The layer tables are computed at compile time.
+namespace Random {
+namespace detail {
+// Just enough constexpr math to build the tables (std::exp and friends aren't constexpr in C++20)
+constexpr double constexpr_exp(double x) {
+    // e^x = 2^k * e^r with |r| <= ln(2) / 2, then a Taylor series for e^r
+    constexpr double ln2{0.69314718055994530942};
+    auto k{static_cast<long long>(x / ln2 + (x < 0 ? -0.5 : 0.5))};
+    double r{x - static_cast<double>(k) * ln2};
+
+    double term{1.0};
+    double sum{1.0};
+    for (int n{1}; n < 30; ++n) {
+        term *= r / n;
+        sum += term;
+    }
+    for (; k > 0; --k) {
+        sum *= 2.0;
+    }
+    for (; k < 0; ++k) {
+        sum /= 2.0;
+    }
+    return sum;
+}
+
+constexpr double constexpr_log(double x) {
+    // x = m * 2^e with m in [sqrt(1/2), sqrt(2)), then log(m) = 2 atanh((m - 1) / (m + 1))
+    constexpr double ln2{0.69314718055994530942};
+    constexpr double sqrt2{1.41421356237309504880};
+    int exponent{};
+    while (x >= sqrt2) {
+        x /= 2.0;
+        ++exponent;
+    }
+    while (x < sqrt2 / 2) {
+        x *= 2.0;
+        --exponent;
+    }
+    double z{(x - 1.0) / (x + 1.0)};
+    double power{z};
+    double sum{};
+    for (int n{1}; n < 60; n += 2) {
+        sum += power / n;
+        power *= z * z;
+    }
+    return 2.0 * sum + exponent * ln2;
+}
+
+constexpr double constexpr_sqrt(double x) {
+    double root{x > 1.0 ? x : 1.0};
+    for (int i{}; i < 100; ++i) {
+        root = 0.5 * (root + x / root);
+    }
+    return root;
+}
+
+// Layer tables for `Layers` layers of a decreasing density f over [0, inf).
+// x[0] is the width the base layer would have if its tail were a rectangle (V / f(R)),
+// x[1] = R, and x[i + 1] is where the layer on top of x[i] ends, down to x[Layers] = 0.
+// ratio[i] = x[i + 1] / x[i] is the part of layer i that lies completely under the curve.
+template <std::size_t Layers> struct ZigguratTables {
+    std::array<double, Layers + 1> x{};
+    std::array<double, Layers + 1> f{};
+    std::array<double, Layers> ratio{};
+};
+
+constexpr ZigguratTables<128> make_normal_tables() {
+    // R and V from Doornik's ZIGNOR for 128 layers; f(x) = exp(-x^2 / 2)
+    constexpr double r{3.442619855899};
+    constexpr double v{9.91256303526217e-3};
+
+    ZigguratTables<128> tables{};
+    tables.f[1] = constexpr_exp(-0.5 * r * r);
+    tables.x[0] = v / tables.f[1];
+    tables.x[1] = r;
+    for (std::size_t i{2}; i < 128; ++i) {
+        tables.x[i] = constexpr_sqrt(-2.0 * constexpr_log(v / tables.x[i - 1] + tables.f[i - 1]));
+        tables.f[i] = constexpr_exp(-0.5 * tables.x[i] * tables.x[i]);
+    }
+    tables.x[128] = 0.0;
+    tables.f[128] = 1.0;
+    tables.f[0] = 0.0; // the base layer is handled by the tail, this entry is never read
+    for (std::size_t i{}; i < 128; ++i) {
+        tables.ratio[i] = tables.x[i + 1] / tables.x[i];
+    }
+    return tables;
+}
+
+constexpr ZigguratTables<256> make_exponential_tables() {
+    // R and V for 256 layers from Marsaglia and Tsang; f(x) = exp(-x)
+    constexpr double r{7.69711747013104972};
+    constexpr double v{3.949659822581572e-3};
+
+    ZigguratTables<256> tables{};
+    tables.f[1] = constexpr_exp(-r);
+    tables.x[0] = v / tables.f[1];
+    tables.x[1] = r;
+    for (std::size_t i{2}; i < 256; ++i) {
+        tables.x[i] = -constexpr_log(v / tables.x[i - 1] + tables.f[i - 1]);
+        tables.f[i] = constexpr_exp(-tables.x[i]);
+    }
+    tables.x[256] = 0.0;
+    tables.f[256] = 1.0;
+    tables.f[0] = 0.0;
+    for (std::size_t i{}; i < 256; ++i) {
+        tables.ratio[i] = tables.x[i + 1] / tables.x[i];
+    }
+    return tables;
+}
+
+inline constexpr ZigguratTables<128> normal_tables{make_normal_tables()};
+inline constexpr ZigguratTables<256> exponential_tables{make_exponential_tables()};
+
+// Uniform in (0, 1], safe to take the log of
+template <typename Engine> double unit_for_log(Engine& rng) {
+    return 1.0 - to_unit<double>(next_u64(rng));
+}
+
+// Bits 12..63 as a value in [-1, 1), the same trick as to_unit. Bits 0..7 are left for the layer.
+inline double signed_unit(std::uint64_t bits) noexcept {
+    return std::bit_cast<double>(0x4000000000000000ULL | (bits >> 12)) - 3.0;
+}
+
+// Finishes a normal draw whose first candidate came from `bits`: the rectangle test, then the
+// tail or wedge test, then fresh candidates until one is accepted.
+template <typename Engine> double normal_from(Engine& rng, std::uint64_t bits) {
+    constexpr auto& table{normal_tables};
+    while (true) {
+        std::size_t layer{static_cast<std::size_t>(bits & 127)};
+        double u{signed_unit(bits)};
+        double x{u * table.x[layer]};
+
+        if (std::abs(u) < table.ratio[layer]) {
+            return x;
+        }
+        if (layer == 0) {
+            // Marsaglia's tail method beyond R
+            double tail{};
+            double y{};
+            do {
+                tail = -std::log(unit_for_log(rng)) / table.x[1];
+                y = -std::log(unit_for_log(rng));
+            } while (y + y < tail * tail);
+            return u < 0 ? -(table.x[1] + tail) : table.x[1] + tail;
+        }
+        double height{table.f[layer] + to_unit<double>(next_u64(rng)) *
+                                           (table.f[layer + 1] - table.f[layer])};
+        if (height < std::exp(-0.5 * x * x)) {
+            return x;
+        }
+        bits = next_u64(rng);
+    }
+}
+
+template <typename Engine> double exponential_from(Engine& rng, std::uint64_t bits) {
+    constexpr auto& table{exponential_tables};
+    while (true) {
+        std::size_t layer{static_cast<std::size_t>(bits & 255)};
+        double u{to_unit<double>(bits)};
+        double x{u * table.x[layer]};
+
+        if (u < table.ratio[layer]) {
+            return x;
+        }
+        if (layer == 0) {
+            // memoryless: the tail beyond R is R plus another exponential
+            return table.x[1] - std::log(unit_for_log(rng));
+        }
+        double height{table.f[layer] + to_unit<double>(next_u64(rng)) *
+                                           (table.f[layer + 1] - table.f[layer])};
+        if (height < std::exp(-x)) {
+            return x;
+        }
+        bits = next_u64(rng);
+    }
+}
+
+// Block filler shared by the normal and exponential fills.
+// The first pass only does the rectangle test, which is a table lookup, a multiply and a compare
+// per value and has no branches, so it vectorizes. The few values that fail it get the full
+// algorithm, starting from their own first candidate, in a second pass.
+template <typename T, std::size_t LayerMask, typename Engine, typename FirstTry, typename Finish>
+void fill_ziggurat(Engine& rng, std::span<T> out, FirstTry first_try, Finish finish) {
+    constexpr std::size_t block_size{256};
+    std::uint64_t bits[block_size];
+    double values[block_size];
+    bool accepted[block_size];
+
+    for (std::size_t done{}; done < out.size();) {
+        std::size_t count{std::min(out.size() - done, block_size)};
+        fill_bits(rng, std::span{bits, count});
+
+        for (std::size_t i{}; i < count; ++i) {
+            accepted[i] = first_try(bits[i], bits[i] & LayerMask, values[i]);
+        }
+        for (std::size_t i{}; i < count; ++i) {
+            if (!accepted[i]) {
+                values[i] = finish(bits[i]);
+            }
+            out[done + i] = static_cast<T>(values[i]);
+        }
+        done += count;
+    }
+}
+} // namespace detail
+
+// Standard normal (mean 0, standard deviation 1) from the given engine
+// Sample call: Random::normal(rng);
+template <std::uniform_random_bit_generator Engine> double normal(Engine& rng) {
+    return detail::normal_from(rng, detail::next_u64(rng));
+}
+
+// Same as above, using the calling thread's engine
+inline double normal() { return normal(engine()); }
+
+// Exponential with rate 1 (mean 1) from the given engine
+template <std::uniform_random_bit_generator Engine> double exponential(Engine& rng) {
+    return detail::exponential_from(rng, detail::next_u64(rng));
+}
+
+// Same as above, using the calling thread's engine
+inline double exponential() { return exponential(engine()); }
+
+// Fill out with normal values of the given mean and standard deviation
+// Sample call: Random::fill_normal(rng, std::span{noise}, 0.0, 2.5);
+template <std::uniform_random_bit_generator Engine, std::floating_point T>
+void fill_normal(Engine& rng, std::span<T> out, std::type_identity_t<T> mean = 0,
+                 std::type_identity_t<T> stddev = 1) {
+    constexpr auto& table{detail::normal_tables};
+    detail::fill_ziggurat<T, 127>(
+        rng, out,
+        [&](std::uint64_t bits, std::uint64_t layer, double& value) {
+            double u{detail::signed_unit(bits)};
+            value = mean + stddev * (u * table.x[layer]);
+            return std::abs(u) < table.ratio[layer];
+        },
+        [&](std::uint64_t bits) { return mean + stddev * detail::normal_from(rng, bits); });
+}
+
+// Same as above, using the calling thread's engine
+template <std::floating_point T>
+void fill_normal(std::span<T> out, std::type_identity_t<T> mean = 0,
+                 std::type_identity_t<T> stddev = 1) {
+    fill_normal(engine(), out, mean, stddev);
+}
+
+// Fill out with exponential values of the given rate (mean 1 / rate)
+template <std::uniform_random_bit_generator Engine, std::floating_point T>
+void fill_exponential(Engine& rng, std::span<T> out, std::type_identity_t<T> rate = 1) {
+    constexpr auto& table{detail::exponential_tables};
+    const double scale{1.0 / rate};
+    detail::fill_ziggurat<T, 255>(
+        rng, out,
+        [&](std::uint64_t bits, std::uint64_t layer, double& value) {
+            double u{to_unit<double>(bits)};
+            value = scale * (u * table.x[layer]);
+            return u < table.ratio[layer];
+        },
+        [&](std::uint64_t bits) { return scale * detail::exponential_from(rng, bits); });
+}
+
+// Same as above, using the calling thread's engine
+template <std::floating_point T>
+void fill_exponential(std::span<T> out, std::type_identity_t<T> rate = 1) {
+    fill_exponential(engine(), out, rate);
+}
+} // namespace Random
+
+#endif // !ZIGGURAT_H